@@ -0,0 +1,145 @@
+/*
+    checkpoint_bench - what snapshots cost the dispatch loop, and how
+                       fast a dispatcher is restored from one
+
+    usage:
+        ./checkpoint_bench [jobs] [snapshots]
+        where [jobs] is the number of jobs per run (default 200000)
+        and [snapshots] how many are taken over a run (default 4)
+
+    Generates a Poisson workload of small, exponential jobs loading the
+    slots to about 90%, and runs it through the simulated dispatcher on
+    4 to 512 CPU slots with t0 = 2, t1 = 3, k = 2: once as it is, once
+    snapshotting to /tmp [snapshots] times, evenly spread. The last
+    snapshot is then restored and run to the end. Prints one CSV
+    row per slot count:
+
+        ns_per_event       wall time of the run / passes through the
+                           dispatch loop, without and with snapshots
+        fork_us, write_ms  the dispatcher is held up by the fork only;
+                           the child then writes the snapshot
+        restore_ms         checkpointRestore of the last snapshot
+        same               1 if the restored run ended as the first did
+*/
+
+/* Include files */
+#include <time.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include "../checkpoint.h"
+#include "../workload.h"
+
+#define DEFAULT_JOBS 200000
+#define DEFAULT_SNAPSHOTS 4
+#define LOAD 0.9
+#define SNAPSHOT_PATH "/tmp/mlqd_checkpoint_bench.snap"
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// run the 'n' jobs of 'records' on 'cpus' slots, snapshotting every 'every'
+// time units unless it is 0; returns ns per dispatch loop pass
+static double run(Dispatcher * d, JobRecord * records, int n, int cpus, int every)
+{
+    if (!initDispatcher(d, cpus, QUEUES_SHARED, MEM_BUDDY))
+        exit(EXIT_FAILURE);
+    d->simulate = TRUE;
+    d->t0 = 2;
+    d->t1 = 3;
+    d->k = 2;
+
+    for (int i = 0; i < n; i++)
+        if (!enqJobRecord(&d->job_queue, &records[i], i))
+            exit(EXIT_FAILURE);
+    d->jobs = n;
+    if (every && !checkpointInit(d, SNAPSHOT_PATH, every))
+        exit(EXIT_FAILURE);
+
+    double start = now_ns();
+    runDispatcher(d);
+    checkpointFinish(d);
+    double elapsed = now_ns() - start;
+
+    return elapsed / (d->events ? d->events : 1);
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : DEFAULT_JOBS;
+    int snapshots = argc > 2 ? atoi(argv[2]) : DEFAULT_SNAPSHOTS;
+    int cpus[] = { 4, 64, 512 };
+    JobRecord * records = (JobRecord *)malloc((size_t)(n > 0 ? n : 1) * sizeof(JobRecord));
+
+    if (n <= 0 || snapshots <= 0 || !records || !initPcbPool(n))
+    {
+        fprintf(stderr, "FATAL: Could not set up the benchmark\n");
+        exit(EXIT_FAILURE);
+    }
+    setPcbSimulated(TRUE);
+    logSetLevel(LOG_QUIET); // the dispatcher and allocator log every step otherwise
+
+    printf("jobs,cpus,snapshots,ns_per_event,ns_per_event_snapshots,fork_us,write_ms,snapshot_mb,restored_jobs,restore_ms,same\n");
+    for (int c = 0; c < (int)(sizeof(cpus) / sizeof(cpus[0])); c++)
+    {
+        Workload spec;
+        Dispatcher d;
+        struct stat st;
+
+        initWorkload(&spec);
+        spec.jobs = n;
+        spec.arrival = ARRIVAL_POISSON;
+        spec.service = SERVICE_EXP;
+        spec.mem = MEM_SMALL;
+        spec.rate = LOAD * cpus[c] / spec.mean_service;
+        if (!genWorkload(&spec, records))
+            exit(EXIT_FAILURE);
+
+        double plain = run(&d, records, n, cpus[c], 0);
+        int runtime = d.timer;
+        double turnaround = d.metrics.all[METRIC_TURNAROUND].sum;
+        closeDispatcher(&d);
+
+        unlink(SNAPSHOT_PATH);
+        // spaced so the last one falls before the end of the run, not on it
+        int every = 2 * runtime / (2 * snapshots + 1);
+        double checkpointed = run(&d, records, n, cpus[c], every > 0 ? every : 1);
+        long taken = d.checkpoints;
+        closeDispatcher(&d);
+
+        // restore the last snapshot, time one more of it, and run it out
+        double start = now_ns();
+        if (!checkpointRestore(&d, SNAPSHOT_PATH, TRUE))
+            exit(EXIT_FAILURE);
+        double restore = now_ns() - start;
+        int restored = 0;
+        for (PcbPtr p = d.job_queue.head; p; p = p->next)
+            restored++;
+        restored += d.busy + d.queued[0] + d.queued[1] + d.queued[2];
+        for (PcbPtr p = d.arrived_queue.head; p; p = p->next)
+            restored++;
+
+        d.checkpoint_path = SNAPSHOT_PATH;
+        start = now_ns();
+        checkpointWrite(&d);
+        double fork_time = now_ns() - start;
+        checkpointFinish(&d);
+        double write = now_ns() - start;
+        d.checkpoint_path = NULL;
+        runDispatcher(&d);
+
+        if (stat(SNAPSHOT_PATH, &st) == -1)
+            st.st_size = 0;
+        printf("%d,%d,%ld,%.1f,%.1f,%.1f,%.2f,%.2f,%d,%.2f,%d\n", n, cpus[c], taken, plain, checkpointed,
+            fork_time / 1e3, write / 1e6, st.st_size / 1048576.0, restored, restore / 1e6,
+            d.timer == runtime && d.metrics.all[METRIC_TURNAROUND].sum == turnaround);
+        closeDispatcher(&d);
+    }
+
+    unlink(SNAPSHOT_PATH);
+    free(records);
+    return 0;
+}
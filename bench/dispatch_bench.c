@@ -0,0 +1,145 @@
+/*
+    dispatch_bench - dispatcher cost and scheduling quality on
+                     synthetic workloads
+
+    usage:
+        ./dispatch_bench [jobs]
+        where [jobs] is the number of jobs per workload (default 20000)
+
+    Generates each workload below (see workload.h), runs it through the
+    simulated dispatcher on 4 CPU slots with t0 = 2, t1 = 3, k = 2, then
+    churns the buddy allocator with the workload's memory sizes. Prints
+    one CSV row per workload so results can be compared across commits:
+
+        ns_per_decision  wall time of the run / jobs started or resumed
+        alloc_ops_per_s  memAlloc + memFree calls per second
+        utilization      service time / (runtime x slots)
+        the rest         dispatcher time in seconds, percentiles from the
+                         dispatcher's job metrics
+*/
+
+/* Include files */
+#include <time.h>
+#include <stdint.h>
+#include "../dispatcher.h"
+#include "../workload.h"
+
+#define DEFAULT_JOBS 20000
+#define BENCH_CPUS 4
+#define ALLOC_OPS 100000
+#define ALLOC_LIVE 64 // blocks held at once while churning the allocator
+
+struct bench_workload {
+    const char * name;
+    int arrival;
+    int service;
+    int mem;
+    double rate; // jobs per second; 4 slots finish about 0.7 jobs/s at mean 5 s
+};
+
+static const struct bench_workload workloads[] = {
+    { "poisson-exp-mixed", ARRIVAL_POISSON, SERVICE_EXP, MEM_MIXED, 0.6 },
+    { "poisson-pareto-small", ARRIVAL_POISSON, SERVICE_PARETO, MEM_SMALL, 0.6 },
+    { "bursty-exp-small", ARRIVAL_BURSTY, SERVICE_EXP, MEM_SMALL, 0.6 },
+    { "bursty-pareto-mixed", ARRIVAL_BURSTY, SERVICE_PARETO, MEM_MIXED, 0.5 },
+    { "diurnal-exp-large", ARRIVAL_DIURNAL, SERVICE_EXP, MEM_LARGE, 0.3 },
+};
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// memAlloc/memFree calls per second over the workload's memory sizes
+static double alloc_rate(JobRecord * records, int n)
+{
+    void * memory = malloc(MEM_LIMIT);
+    MabPtr root = memInit((uintptr_t)memory, MEM_LIMIT);
+    MabPtr live[ALLOC_LIVE] = { NULL };
+    uint64_t state = 88172645463325252ULL;
+
+    if (!memory || !root)
+        exit(EXIT_FAILURE);
+
+    double start = now_ns();
+    for (int i = 0; i < ALLOC_OPS; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        int slot = (int)(state % ALLOC_LIVE);
+        if (live[slot])
+        {
+            memFree(live[slot]);
+            live[slot] = NULL;
+        }
+        else
+            live[slot] = memAlloc(root, records[i % n].mem_size);
+    }
+    double elapsed = now_ns() - start;
+
+    memClose(root);
+    free(memory);
+    return ALLOC_OPS / (elapsed / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : DEFAULT_JOBS;
+    JobRecord * records = (JobRecord *)malloc((size_t)(n > 0 ? n : 1) * sizeof(JobRecord));
+
+    if (n <= 0 || !records || !initPcbPool(n))
+    {
+        fprintf(stderr, "FATAL: Could not set up the benchmark\n");
+        exit(EXIT_FAILURE);
+    }
+    setPcbSimulated(TRUE);
+    logSetLevel(LOG_QUIET); // the dispatcher and allocator log every step otherwise
+
+    printf("workload,jobs,cpus,decisions,ns_per_decision,alloc_ops_per_s,runtime,utilization,"
+        "turnaround_mean,turnaround_p99,wait_mean,wait_p99,response_p99\n");
+    for (int w = 0; w < (int)(sizeof(workloads) / sizeof(workloads[0])); w++)
+    {
+        Workload spec;
+        Dispatcher d;
+        double service = 0.0;
+
+        initWorkload(&spec);
+        spec.jobs = n;
+        spec.arrival = workloads[w].arrival;
+        spec.service = workloads[w].service;
+        spec.mem = workloads[w].mem;
+        spec.rate = workloads[w].rate;
+        if (!genWorkload(&spec, records) || !initDispatcher(&d, BENCH_CPUS, QUEUES_SHARED, MEM_BUDDY))
+            exit(EXIT_FAILURE);
+        d.simulate = TRUE;
+        d.t0 = 2;
+        d.t1 = 3;
+        d.k = 2;
+
+        for (int i = 0; i < n; i++)
+        {
+            if (!enqJobRecord(&d.job_queue, &records[i], i))
+                exit(EXIT_FAILURE);
+            service += records[i].service_time;
+        }
+
+        double start = now_ns();
+        runDispatcher(&d);
+        double elapsed = now_ns() - start;
+
+        JobMetricsPtr m = &d.metrics;
+        printf("%s,%d,%d,%ld,%.1f,%.0f,%d,%.3f,%.3f,%ld,%.3f,%ld,%ld\n", workloads[w].name,
+            n, BENCH_CPUS, d.dispatches, elapsed / (d.dispatches ? d.dispatches : 1),
+            alloc_rate(records, n), d.timer, d.timer ? service / ((double)d.timer * BENCH_CPUS) : 0.0,
+            m->all[METRIC_TURNAROUND].sum / n, percentileHist(&m->all[METRIC_TURNAROUND], 99),
+            m->all[METRIC_WAIT].sum / n, percentileHist(&m->all[METRIC_WAIT], 99),
+            percentileHist(&m->all[METRIC_RESPONSE], 99));
+        closeDispatcher(&d);
+    }
+
+    free(records);
+    return 0;
+}
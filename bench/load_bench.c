@@ -0,0 +1,87 @@
+/*
+    load_bench - startup cost of the text and binary job list loaders
+
+    usage:
+        ./load_bench [jobs]
+        where [jobs] is the number of jobs in the generated lists
+        (default 1000000)
+
+    Writes the same synthetic job list in both formats to /tmp and
+    reports how long loadJobList takes to build the job queue from each.
+*/
+
+/* Include files */
+#include <time.h>
+#include "../jobfile.h"
+
+#define DEFAULT_JOBS 1000000
+#define TEXT_PATH "/tmp/mlqd_load_bench.txt"
+#define BIN_PATH "/tmp/mlqd_load_bench.job"
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+static double time_load(char * path, int expected)
+{
+    PcbQueue q;
+    initPcbQ(&q);
+
+    double start = now_ms();
+    int n = loadJobList(path, &q);
+    double elapsed = now_ms() - start;
+
+    if (n != expected)
+    {
+        fprintf(stderr, "FATAL: %s loaded %d of %d jobs\n", path, n, expected);
+        exit(EXIT_FAILURE);
+    }
+    while (q.head)
+        freePcb(deqPcbQ(&q));
+    return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : DEFAULT_JOBS;
+    JobRecord * records = (JobRecord *)malloc((size_t)n * sizeof(JobRecord) + 1);
+    FILE * text;
+
+    if (n <= 0 || !records || !(text = fopen(TEXT_PATH, "w")))
+    {
+        fprintf(stderr, "FATAL: Could not set up the benchmark job lists\n");
+        exit(EXIT_FAILURE);
+    }
+
+    srand(1);
+    for (int i = 0, arrival = 0; i < n; i++)
+    {
+        arrival += rand() % 3;
+        records[i].arrival_time = arrival;
+        records[i].service_time = 1 + rand() % 20;
+        records[i].mem_size = 1 + rand() % 1024;
+        fprintf(text, "%d, %d, %d\n", records[i].arrival_time,
+            records[i].service_time, records[i].mem_size);
+    }
+    fclose(text);
+    if (!writeBinJobList(BIN_PATH, records, n))
+        exit(EXIT_FAILURE);
+    free(records);
+
+    // warm the page cache and the Pcb pool so both loaders start equal
+    time_load(BIN_PATH, n);
+
+    double text_ms = time_load(TEXT_PATH, n);
+    double bin_ms = time_load(BIN_PATH, n);
+
+    printf("%10s %12s %12s\n", "format", "load ms", "ns/job");
+    printf("%10s %12.1f %12.1f\n", "text", text_ms, text_ms * 1e6 / n);
+    printf("%10s %12.1f %12.1f\n", "binary", bin_ms, bin_ms * 1e6 / n);
+
+    remove(TEXT_PATH);
+    remove(BIN_PATH);
+    return 0;
+}
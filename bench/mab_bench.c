@@ -0,0 +1,127 @@
+/*
+    mab_bench - buddy heap cost, pointer tree vs flat bitmaps
+
+    usage:
+        ./mab_bench            (pointer tree, mab.c)
+        ./mab_bench_bitmap     (flat bitmaps, mab_bitmap.c)
+
+    Both are built from this file, one per backend. Each pattern churns
+    a heap of MEM_LIMIT megabytes: a random slot of ALLOC_LIVE is freed
+    if it holds a block, else a block is allocated into it. "fill"
+    instead allocates minimum-size blocks until the heap is full, then
+    frees them all, which is the deepest split/merge case. Prints one
+    CSV row per pattern:
+
+        ns_per_op      wall time / (memAlloc + memFree calls)
+        alloc_cycles   mean cycles in memAlloc, from memStats
+        free_cycles    mean cycles in memFree
+        failures       memAlloc calls that found no block
+*/
+
+/* Include files */
+#include <time.h>
+#include "../mab.h"
+
+#define ALLOC_OPS 2000000
+#define ALLOC_LIVE 64 // blocks held at once while churning
+#define FILL_ROUNDS 2000
+
+#ifdef MAB_BITMAP
+#define BACKEND "bitmap"
+#else
+#define BACKEND "tree"
+#endif
+
+struct pattern {
+    const char * name;
+    int lo, hi; // megabytes, log-uniform
+};
+
+static const struct pattern patterns[] = {
+    { "small", 1, 64 },
+    { "mixed", 1, 1024 },
+    { "large", 256, MEM_LIMIT },
+};
+
+static uint64_t state = 88172645463325252ULL;
+
+static uint64_t next_random(void)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void report(const char * name, MabPtr root, long ops, double elapsed)
+{
+    MabStatsPtr s = memStats(root);
+    long calls = s->allocs + s->failures;
+    printf("%s,%s,%ld,%.1f,%.0f,%.0f,%ld\n", BACKEND, name, ops, elapsed / ops,
+        calls ? (double)s->alloc_cycles / calls : 0.0,
+        s->frees ? (double)s->free_cycles / s->frees : 0.0, s->failures);
+}
+
+int main(void)
+{
+    static MabPtr fill[MEM_LIMIT / BLOCK_MIN_SIZE];
+    int sizes[4096];
+
+    printf("backend,pattern,ops,ns_per_op,alloc_cycles,free_cycles,failures\n");
+    for (int p = 0; p < (int)(sizeof(patterns) / sizeof(patterns[0])); p++)
+    {
+        MabPtr root = memInit(0, MEM_LIMIT);
+        MabPtr live[ALLOC_LIVE] = { NULL };
+        if (!root)
+            exit(EXIT_FAILURE);
+
+        // sizes are drawn up front so the loop only times the heap
+        for (int i = 0; i < 4096; i++)
+        {
+            int size = patterns[p].lo;
+            while (size < patterns[p].hi && (next_random() & 1))
+                size *= 2;
+            sizes[i] = size + (int)(next_random() % (size < patterns[p].hi ? size : 1));
+        }
+
+        double start = now_ns();
+        for (int i = 0; i < ALLOC_OPS; i++)
+        {
+            int slot = (int)(next_random() % ALLOC_LIVE);
+            if (live[slot])
+            {
+                memFree(live[slot]);
+                live[slot] = NULL;
+            }
+            else
+                live[slot] = memAlloc(root, sizes[i & 4095]);
+        }
+        report(patterns[p].name, root, ALLOC_OPS, now_ns() - start);
+        memClose(root);
+    }
+
+    MabPtr root = memInit(0, MEM_LIMIT);
+    if (!root)
+        exit(EXIT_FAILURE);
+    long ops = 0;
+    double start = now_ns();
+    for (int round = 0; round < FILL_ROUNDS; round++)
+    {
+        int n = 0;
+        while ((fill[n] = memAlloc(root, BLOCK_MIN_SIZE)))
+            n++;
+        for (int i = 0; i < n; i++)
+            memFree(fill[i]);
+        ops += 2 * n + 1;
+    }
+    report("fill", root, ops, now_ns() - start);
+    memClose(root);
+    return 0;
+}
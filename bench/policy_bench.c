@@ -0,0 +1,160 @@
+/*
+    policy_bench - memory allocation policies replayed on the same jobs
+
+    usage:
+        ./policy_bench [JOBFILE...]
+        where each JOBFILE is a text or binary job list; without any,
+        test1, test2 and three generated workloads are used
+
+    Every job list is run through the simulated dispatcher once per
+    allocation policy (see --mem) on 4 CPU slots with t0 = 2, t1 = 3,
+    k = 2, so the only difference between the rows of a job list is
+    where memory was found for each job. Prints one CSV row per job
+    list and policy:
+
+        admission_*     seconds jobs waited in the Arrived Queue
+        util_requested  memory the admitted jobs asked for, averaged over
+                        the run, as a fraction of MEM_LIMIT
+        util_allocated  the same for the blocks they were given
+        alloc_cycles    mean cycles per memAlloc call, from memStats
+        free_cycles     mean cycles per memFree call
+        failures        memAlloc calls that found no block
+        fragmented      ... although enough memory was free in total
+*/
+
+/* Include files */
+#include "../dispatcher.h"
+#include "../workload.h"
+
+#define GEN_JOBS 5000
+#define BENCH_CPUS 4
+
+struct bench_workload {
+    const char * name;
+    int arrival;
+    int service;
+    int mem;
+    double rate;
+};
+
+static const struct bench_workload workloads[] = {
+    { "poisson-exp-mixed", ARRIVAL_POISSON, SERVICE_EXP, MEM_MIXED, 0.6 },
+    { "bursty-pareto-mixed", ARRIVAL_BURSTY, SERVICE_PARETO, MEM_MIXED, 0.5 },
+    { "diurnal-exp-large", ARRIVAL_DIURNAL, SERVICE_EXP, MEM_LARGE, 0.3 },
+};
+
+static const char * default_files[] = { "test1", "test2" };
+
+// load a job list into records, NULL if it could not be read
+static JobRecord * load_records(char * path, int * n)
+{
+    PcbQueue queue = { NULL, NULL, 0 };
+    JobRecord * records;
+    PcbPtr p;
+
+    if (loadJobList(path, &queue) < 0)
+        return NULL;
+    if (!(records = (JobRecord *)malloc((size_t)queue.count * sizeof(JobRecord) + 1)))
+        exit(EXIT_FAILURE);
+    *n = 0;
+    while ((p = deqPcbQ(&queue)))
+    {
+        records[*n].arrival_time = p->arrival_time;
+        records[*n].service_time = p->service_time;
+        records[*n].mem_size = p->mem_size;
+        (*n)++;
+        freePcb(p);
+    }
+    return records;
+}
+
+// replay 'records' once per policy
+static void replay(const char * name, JobRecord * records, int n)
+{
+    for (int policy = 0; policy < MEM_POLICIES; policy++)
+    {
+        Dispatcher d;
+
+        if (!initPcbPool(n) || !initDispatcher(&d, BENCH_CPUS, QUEUES_SHARED, policy))
+            exit(EXIT_FAILURE);
+        d.simulate = TRUE;
+        d.t0 = 2;
+        d.t1 = 3;
+        d.k = 2;
+        for (int i = 0; i < n; i++)
+            if (!enqJobRecord(&d.job_queue, &records[i], i))
+                exit(EXIT_FAILURE);
+
+        int ok = runDispatcher(&d);
+
+        LatencyHistPtr a = &d.admission;
+        MabStatsPtr s = memStats(d.first_block);
+        double capacity = (double)MEM_LIMIT * (d.timer ? d.timer : 1);
+        long calls = s->allocs + s->failures;
+        printf("%s,%s,%d,%d,%.3f,%ld,%ld,%.3f,%.3f,%.0f,%.0f,%ld,%ld,%.3f%s\n",
+            name, memPolicyName(policy), n, d.timer,
+            a->count ? a->sum / a->count : 0.0, percentileHist(a, 99), a->max,
+            d.requested_area / capacity, d.allocated_area / capacity,
+            calls ? (double)s->alloc_cycles / calls : 0.0,
+            s->frees ? (double)s->free_cycles / s->frees : 0.0,
+            s->failures, s->fragmented,
+            d.metrics.all[METRIC_TURNAROUND].count
+                ? d.metrics.all[METRIC_TURNAROUND].sum / d.metrics.all[METRIC_TURNAROUND].count : 0.0,
+            ok ? "" : ",deadlock");
+        closeDispatcher(&d);
+        closePcbPool();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    setPcbSimulated(TRUE);
+    logSetLevel(LOG_QUIET);
+
+    printf("trace,policy,jobs,runtime,admission_mean,admission_p99,admission_max,"
+        "util_requested,util_allocated,alloc_cycles,free_cycles,failures,fragmented,turnaround_mean\n");
+
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            int n;
+            JobRecord * records = load_records(argv[i], &n);
+            if (!records)
+                exit(EXIT_FAILURE);
+            replay(argv[i], records, n);
+            free(records);
+        }
+        return 0;
+    }
+
+    for (int i = 0; i < (int)(sizeof(default_files) / sizeof(default_files[0])); i++)
+    {
+        int n;
+        JobRecord * records = load_records((char *)default_files[i], &n);
+        if (!records)
+            continue; // not run from the repository root
+        replay(default_files[i], records, n);
+        free(records);
+    }
+
+    JobRecord * records = (JobRecord *)malloc(GEN_JOBS * sizeof(JobRecord));
+    if (!records)
+        exit(EXIT_FAILURE);
+    for (int w = 0; w < (int)(sizeof(workloads) / sizeof(workloads[0])); w++)
+    {
+        Workload spec;
+
+        initWorkload(&spec);
+        spec.jobs = GEN_JOBS;
+        spec.arrival = workloads[w].arrival;
+        spec.service = workloads[w].service;
+        spec.mem = workloads[w].mem;
+        spec.rate = workloads[w].rate;
+        if (!genWorkload(&spec, records))
+            exit(EXIT_FAILURE);
+        replay(workloads[w].name, records, GEN_JOBS);
+    }
+    free(records);
+    return 0;
+}
@@ -0,0 +1,73 @@
+/*
+    queue_bench - enqueue cost of the Pcb queues as queue depth grows
+
+    usage:
+        ./queue_bench
+
+    For each depth, fills a queue with that many Pcbs and reports the
+    average cost of one enqueue. enqPcbQ should stay flat, enqPcb grows
+    linearly with depth (it walks the whole queue).
+*/
+
+/* Include files */
+#include <time.h>
+#include "../pcb.h"
+
+#define MAX_DEPTH 1000000
+#define MAX_LIST_DEPTH 20000 // enqPcb is O(n^2) to fill, keep it short
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+    static const int depths[] = { 1000, 10000, 20000, 100000, 1000000 };
+    PcbPtr pcbs = (PcbPtr)calloc(MAX_DEPTH, sizeof(Pcb));
+    if (!pcbs)
+    {
+        fprintf(stderr, "FATAL: Could not allocate benchmark Pcbs\n");
+        exit(EXIT_FAILURE);
+    }
+
+    printf("%10s %16s %16s\n", "depth", "enqPcbQ ns/op", "enqPcb ns/op");
+    for (int d = 0; d < (int)(sizeof(depths) / sizeof(depths[0])); d++)
+    {
+        int n = depths[d];
+        double start, q_ns, list_ns = -1.0;
+
+        // O(1) tail-tracked queue
+        PcbQueue q;
+        initPcbQ(&q);
+        start = now_ns();
+        for (int i = 0; i < n; i++)
+            enqPcbQ(&q, &pcbs[i]);
+        q_ns = (now_ns() - start) / n;
+        while (deqPcbQ(&q))
+            ;
+
+        // legacy head-only list
+        if (n <= MAX_LIST_DEPTH)
+        {
+            PcbPtr head = NULL;
+            start = now_ns();
+            for (int i = 0; i < n; i++)
+            {
+                pcbs[i].next = NULL;
+                head = enqPcb(head, &pcbs[i]);
+            }
+            list_ns = (now_ns() - start) / n;
+        }
+
+        if (list_ns < 0)
+            printf("%10d %16.1f %16s\n", n, q_ns, "-");
+        else
+            printf("%10d %16.1f %16.1f\n", n, q_ns, list_ns);
+    }
+
+    free(pcbs);
+    return 0;
+}
@@ -0,0 +1,93 @@
+/*
+    steal_bench - shared Level-0/1/2 queues against per-CPU queues
+                  with work stealing
+
+    usage:
+        ./steal_bench [jobs]
+        where [jobs] is the number of jobs in the generated list
+        (default 20000)
+
+    Runs the same synthetic job list through the simulated dispatcher
+    at 1, 4, 16 and 64 CPU slots with each queue layout, and reports
+    the dispatcher cost per job, how many jobs were stolen from a peer,
+    how many suspended jobs resumed on another slot, and the resulting
+    runtime and average turnaround.
+*/
+
+/* Include files */
+#include <time.h>
+#include "../dispatcher.h"
+#include "../jobfile.h"
+
+#define DEFAULT_JOBS 20000
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// the job list of every run: bursts of arrivals that keep all slots busy
+static void gen_jobs(JobRecord * records, int n)
+{
+    srand(1);
+    for (int i = 0; i < n; i++)
+    {
+        records[i].arrival_time = i / 50;
+        records[i].service_time = 1 + rand() % 20;
+        records[i].mem_size = BLOCK_MIN_SIZE << (rand() % 3);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static const int cpus[] = { 1, 4, 16, 64 };
+    static const char * layouts[] = { "shared", "per-cpu" };
+    int n = argc > 1 ? atoi(argv[1]) : DEFAULT_JOBS;
+    JobRecord * records = (JobRecord *)malloc((size_t)(n > 0 ? n : 1) * sizeof(JobRecord));
+
+    if (n <= 0 || !records || !initPcbPool(n))
+    {
+        fprintf(stderr, "FATAL: Could not set up the benchmark\n");
+        exit(EXIT_FAILURE);
+    }
+    setPcbSimulated(TRUE);
+    logSetLevel(LOG_QUIET); // the dispatcher and allocator log every step otherwise
+    gen_jobs(records, n);
+
+    printf("%5s %8s %10s %8s %10s %8s %12s\n",
+        "cpus", "queues", "ns/job", "steals", "migrated", "runtime", "turnaround");
+    for (int c = 0; c < (int)(sizeof(cpus) / sizeof(cpus[0])); c++)
+    {
+        for (int layout = QUEUES_SHARED; layout <= QUEUES_PER_CPU; layout++)
+        {
+            Dispatcher d;
+            double start, elapsed, turnaround = 0.0;
+
+            if (!initDispatcher(&d, cpus[c], layout, MEM_BUDDY))
+                exit(EXIT_FAILURE);
+            d.simulate = TRUE;
+            d.t0 = 2;
+            d.t1 = 3;
+            d.k = 2;
+            for (int i = 0; i < n; i++)
+                if (!enqJobRecord(&d.job_queue, &records[i], i))
+                    exit(EXIT_FAILURE);
+            d.jobs = n;
+
+            start = now_ns();
+            runDispatcher(&d);
+            elapsed = now_ns() - start;
+
+            for (int i = 0; i < d.cpus; i++)
+                turnaround += d.slots[i].turnaround_time;
+            printf("%5d %8s %10.1f %8ld %10ld %8d %12.1f\n", cpus[c], layouts[layout],
+                elapsed / n, d.steals, d.migrations, d.timer, turnaround / n);
+            closeDispatcher(&d);
+        }
+    }
+
+    free(records);
+    return 0;
+}
@@ -0,0 +1,190 @@
+/*
+    submit_bench - sustained job submission throughput
+
+    usage:
+        ./submit_bench [jobs]
+        where [jobs] is the number of jobs per producer (default 200000)
+
+    The main thread plays the dispatcher: it waits on the intake's
+    eventfd, pops every job and frees it. Producers are
+        queue     threads calling intakePush directly (the lock-free list)
+        socket    jobsend-style clients writing "service, mem" lines to a
+                  Unix socket served by intakeListen
+        held      socket clients, but the consumer only admits 64 jobs
+                  per 100 us and reports the rest as its backlog, so the
+                  clients are held back at max_pending (256); queue and
+                  socket runs use a limit they never reach
+    Prints one CSV row per run:
+
+        jobs_per_s     jobs popped / wall time from first send to last pop
+        peak_pending   most jobs seen submitted but not admitted
+        held           times a client was held back
+*/
+
+/* Include files */
+#include <poll.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "../intake.h"
+
+#define DEFAULT_JOBS 200000
+#define HELD_MAX_PENDING 256
+#define HELD_ADMIT 64 // jobs admitted per HELD_ADMIT_US
+#define HELD_ADMIT_US 100
+
+struct producer {
+    pthread_t thread;
+    IntakePtr intake;
+    const char * path; // NULL: push directly
+    long jobs;
+};
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void * producer_thread(void * arg)
+{
+    struct producer * p = (struct producer *)arg;
+    char buffer[16384];
+    size_t used = 0;
+
+    if (!p->path)
+    {
+        for (long i = 0; i < p->jobs; i++)
+        {
+            IntakeJobPtr job = (IntakeJobPtr)malloc(sizeof(IntakeJob));
+            if (!job)
+                exit(EXIT_FAILURE);
+            job->service_time = 1 + (int)(i % 10);
+            job->mem_size = 1 + (int)(i % 256);
+            intakePush(p->intake, job);
+            if ((i & 255) == 255)
+                intakeWake(p->intake);
+        }
+        intakeWake(p->intake);
+        return NULL;
+    }
+
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, p->path);
+    if (fd == -1 || connect(fd, (struct sockaddr *)&address, sizeof(address)) == -1)
+    {
+        perror("FATAL: Could not connect to the intake");
+        exit(EXIT_FAILURE);
+    }
+    for (long i = 0; i <= p->jobs; i++)
+    {
+        if (i == p->jobs || used + 32 > sizeof(buffer))
+        {
+            for (size_t off = 0; off < used; )
+            {
+                ssize_t n = send(fd, buffer + off, used - off, MSG_NOSIGNAL);
+                if (n <= 0)
+                    exit(EXIT_FAILURE);
+                off += n;
+            }
+            used = 0;
+        }
+        if (i < p->jobs)
+            used += sprintf(buffer + used, "%d, %d\n", 1 + (int)(i % 10), 1 + (int)(i % 256));
+    }
+    close(fd);
+    return NULL;
+}
+
+// run 'producers' producers of 'jobs' each against a fresh intake
+static void run(const char * mode, int producers, long jobs)
+{
+    int held = strcmp(mode, "held") == 0;
+    IntakePtr in = intakeCreate(held ? HELD_MAX_PENDING : INTAKE_MAX_PENDING * 16);
+    struct producer p[16];
+    char path[64];
+    long total = jobs * producers, popped = 0, admitted = 0, peak = 0;
+    double next_admit = 0.0;
+
+    snprintf(path, sizeof(path), "/tmp/submit_bench.%d.sock", (int)getpid());
+    if (!in || (strcmp(mode, "queue") != 0 && !intakeListen(in, path)))
+        exit(EXIT_FAILURE);
+
+    double start = now_s();
+    for (int i = 0; i < producers; i++)
+    {
+        p[i].intake = in;
+        p[i].path = strcmp(mode, "queue") == 0 ? NULL : path;
+        p[i].jobs = jobs;
+        if (pthread_create(&p[i].thread, NULL, producer_thread, &p[i]) != 0)
+            exit(EXIT_FAILURE);
+    }
+
+    while (admitted < total)
+    {
+        IntakeJobPtr job;
+        int got = 0;
+
+        while ((job = intakePop(in)))
+        {
+            free(job);
+            popped++;
+            got++;
+        }
+        long pending = popped - admitted + __atomic_load_n(&in->depth, __ATOMIC_RELAXED);
+        if (pending > peak)
+            peak = pending;
+
+        if (!held)
+            admitted = popped;
+        else if (now_s() >= next_admit)
+        {
+            admitted += popped - admitted < HELD_ADMIT ? popped - admitted : HELD_ADMIT;
+            next_admit = now_s() + HELD_ADMIT_US / 1e6;
+        }
+        intakeSetBacklog(in, popped - admitted);
+
+        if (!got && admitted == popped)
+        {
+            // nothing to do until a producer signals
+            struct pollfd pfd = { in->wake_fd, POLLIN, 0 };
+            uint64_t signalled;
+            if (poll(&pfd, 1, 1) == 1 && read(in->wake_fd, &signalled, sizeof(signalled)) < 0)
+                exit(EXIT_FAILURE);
+        }
+        else if (held && !got)
+            usleep(HELD_ADMIT_US / 4);
+    }
+    double elapsed = now_s() - start;
+
+    for (int i = 0; i < producers; i++)
+        pthread_join(p[i].thread, NULL);
+    printf("%s,%d,%ld,%.3f,%.0f,%ld,%ld\n", mode, producers, total, elapsed,
+        total / elapsed, peak, in->held);
+    intakeDestroy(in);
+}
+
+int main(int argc, char *argv[])
+{
+    long jobs = argc > 1 ? atol(argv[1]) : DEFAULT_JOBS;
+    int producers[] = { 1, 2, 4 };
+
+    if (jobs <= 0)
+    {
+        fprintf(stderr, "Usage: %s [jobs]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    printf("mode,producers,jobs,seconds,jobs_per_s,peak_pending,held\n");
+    for (int i = 0; i < 3; i++)
+        run("queue", producers[i], jobs);
+    for (int i = 0; i < 3; i++)
+        run("socket", producers[i], jobs);
+    run("held", 2, jobs / 10);
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+    wheel_bench - cost of a dispatcher step as slots and pending jobs grow
+
+    usage:
+        ./wheel_bench [jobs]
+        where [jobs] is the number of jobs per run (default 100000)
+
+    Generates a Poisson workload of small, exponential jobs loading the
+    slots to about 90%, and runs it through the simulated dispatcher on
+    4 to 512 CPU slots with t0 = 2, t1 = 3, k = 2: once with the jobs in
+    arrival order and once shuffled (ids kept, so ties still go in file
+    order and both runs schedule the same). Prints one CSV row per run:
+
+        ns_per_event  wall time of the run / passes through the dispatch loop
+        the rest      dispatcher time in seconds, mean turnaround
+*/
+
+/* Include files */
+#include <time.h>
+#include <stdint.h>
+#include "../dispatcher.h"
+#include "../workload.h"
+
+#define DEFAULT_JOBS 100000
+#define LOAD 0.9
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// run the 'n' jobs of 'records' on 'cpus' slots, in the order 'order' gives
+static void run(JobRecord * records, int * order, int n, int cpus, const char * name)
+{
+    Dispatcher d;
+
+    if (!initDispatcher(&d, cpus, QUEUES_SHARED, MEM_BUDDY))
+        exit(EXIT_FAILURE);
+    d.simulate = TRUE;
+    d.t0 = 2;
+    d.t1 = 3;
+    d.k = 2;
+
+    for (int i = 0; i < n; i++)
+        if (!enqJobRecord(&d.job_queue, &records[order[i]], order[i]))
+            exit(EXIT_FAILURE);
+
+    double start = now_ns();
+    runDispatcher(&d);
+    double elapsed = now_ns() - start;
+
+    printf("%s,%d,%d,%ld,%.1f,%d,%.3f\n", name, n, cpus, d.events, elapsed / (d.events ? d.events : 1),
+        d.timer, d.metrics.all[METRIC_TURNAROUND].sum / n);
+    closeDispatcher(&d);
+}
+
+int main(int argc, char *argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : DEFAULT_JOBS;
+    int cpus[] = { 4, 64, 512 };
+    JobRecord * records = (JobRecord *)malloc((size_t)(n > 0 ? n : 1) * sizeof(JobRecord));
+    int * order = (int *)malloc((size_t)(n > 0 ? n : 1) * sizeof(int));
+
+    if (n <= 0 || !records || !order || !initPcbPool(n))
+    {
+        fprintf(stderr, "FATAL: Could not set up the benchmark\n");
+        exit(EXIT_FAILURE);
+    }
+    setPcbSimulated(TRUE);
+    logSetLevel(LOG_QUIET); // the dispatcher and allocator log every step otherwise
+
+    printf("order,jobs,cpus,events,ns_per_event,runtime,turnaround_mean\n");
+    for (int c = 0; c < (int)(sizeof(cpus) / sizeof(cpus[0])); c++)
+    {
+        Workload spec;
+        uint64_t state = 88172645463325252ULL;
+
+        initWorkload(&spec);
+        spec.jobs = n;
+        spec.arrival = ARRIVAL_POISSON;
+        spec.service = SERVICE_EXP;
+        spec.mem = MEM_SMALL;
+        spec.rate = LOAD * cpus[c] / spec.mean_service;
+        if (!genWorkload(&spec, records))
+            exit(EXIT_FAILURE);
+
+        for (int i = 0; i < n; i++)
+            order[i] = i;
+        run(records, order, n, cpus[c], "sorted");
+
+        for (int i = n - 1; i > 0; i--)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            int j = (int)(state % (uint64_t)(i + 1));
+            int swap = order[i];
+            order[i] = order[j];
+            order[j] = swap;
+        }
+        run(records, order, n, cpus[c], "shuffled");
+    }
+
+    free(records);
+    free(order);
+    return 0;
+}
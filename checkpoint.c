@@ -0,0 +1,586 @@
+/* Dispatcher snapshots for MLQD dispatcher
+
+   A snapshot is taken at the top of a dispatch step, between two
+   scheduling events, so restoring it and running on makes the same
+   decisions the dispatcher would have made. The dispatcher forks and
+   the child writes the snapshot from its copy-on-write image of the
+   parent's memory, so the scheduler only pays for the fork. The child
+   sticks to async-signal-safe calls (the parent has other threads)
+   and a static buffer: it writes FILE.tmp, syncs it and renames it
+   over FILE, so FILE is always a whole snapshot.
+
+   Restoring rebuilds the queues in order, allocates every job's block
+   again at its old offset, and takes over the processes still running
+   from the old dispatcher, matched by pid and start time (adoptPcb).
+   Jobs whose process is gone start afresh when they are next
+   dispatched. Jobs that finished after the snapshot was taken are
+   run again.
+*/
+
+/* Include Files */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "checkpoint.h"
+
+static volatile sig_atomic_t requested = FALSE; // SIGUSR1 received, or checkpointRequest called
+
+static void on_sigusr1(int sig)
+{
+    (void)sig;
+    requested = TRUE;
+}
+
+/* Snapshot writer output, only used in the forked child */
+static struct {
+    int fd;
+    int failed;
+    size_t used;
+    char buffer[1 << 16];
+} out;
+
+/*******************************************************
+ * static helpers - writing a snapshot (in the forked child)
+ ******************************************************/
+
+static void flush_out(void)
+{
+    size_t done = 0;
+
+    while (done < out.used && !out.failed)
+    {
+        ssize_t n = write(out.fd, out.buffer + done, out.used - done);
+        if (n > 0)
+            done += n;
+        else if (n == -1 && errno != EINTR)
+            out.failed = TRUE;
+    }
+    out.used = 0;
+}
+
+static void put(const void * data, size_t size)
+{
+    const char * from = (const char *)data;
+
+    while (size && !out.failed)
+    {
+        size_t n = sizeof(out.buffer) - out.used;
+        if (n > size)
+            n = size;
+        memcpy(out.buffer + out.used, from, n);
+        out.used += n;
+        from += n;
+        size -= n;
+        if (out.used == sizeof(out.buffer))
+            flush_out();
+    }
+}
+
+// one record per job of 'q', head first
+static void put_queue(DispatcherPtr d, PcbQueuePtr q, int queue, int slot, int level)
+{
+    CheckpointJob r;
+
+    for (PcbPtr p = q->head; p; p = p->next)
+    {
+        memset(&r, 0, sizeof(r));
+        r.queue = queue;
+        r.slot = slot;
+        r.level = level;
+        r.id = p->id;
+        r.pid = p->pid;
+        r.arrival_time = p->arrival_time;
+        r.start_time = p->start_time;
+        r.service_time = p->service_time;
+        r.remaining_cpu_time = p->remaining_cpu_time;
+        r.status = p->status;
+        r.max_iterations = p->max_iterations;
+        r.curr_iterations = p->curr_iterations;
+        r.mem_size = p->mem_size;
+        r.bypass_count = p->bypass_count;
+        r.cpu = p->cpu;
+        r.first_start_time = p->first_start_time;
+        r.preemptions = p->preemptions;
+        r.quantum_left = p->quantum_left;
+        r.mem_offset = p->mem_block ? p->mem_block->offset - d->first_block->offset : -1;
+        r.mem_block_size = p->mem_block ? p->mem_block->size : 0;
+        r.cpu_used_us = p->cpu_used_us;
+        r.cpu_charged_us = p->cpu_charged_us;
+        r.start_time_ticks = !d->simulate && p->pid > 0 ? pcbStartTime(p->pid) : 0;
+        put(&r, sizeof(r));
+        if (queue == CHECKPOINT_RUNNING)
+            break; // a slot runs one job, it is not linked to the others
+    }
+}
+
+// write the snapshot of 'd' to 'path' through 'path'.tmp; FALSE on any error
+static int write_snapshot(DispatcherPtr d, const char * path)
+{
+    static CheckpointHeader h; // too big for the stack with the metrics
+    static int32_t free_offsets[MEM_LIMIT]; // free blocks are at least 1 MB
+    char tmp[PATH_MAX], dir[PATH_MAX];
+    size_t len = strlen(path);
+    int fd;
+
+    if (len + sizeof(".tmp") > sizeof(tmp))
+        return FALSE;
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", sizeof(".tmp"));
+    if ((out.fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) == -1)
+        return FALSE;
+    out.used = 0;
+    out.failed = FALSE;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.version = CHECKPOINT_VERSION;
+    h.header_size = sizeof(CheckpointHeader);
+    h.slot_size = sizeof(CheckpointSlot);
+    h.job_size = sizeof(CheckpointJob);
+    h.cpus = d->cpus;
+    h.jobs = d->job_queue.count + d->arrived_queue.count + d->busy;
+    for (int level = 0; level < LEVELS; level++)
+        h.jobs += d->queued[level];
+    h.free_blocks = memFreeOrder(d->first_block, free_offsets, MEM_LIMIT);
+    h.layout = d->layout;
+    h.mem_policy = d->mem_policy;
+    h.time_unit = d->time_unit;
+    h.accounting = d->accounting;
+    h.simulate = d->simulate;
+    h.timer = d->timer;
+    h.t0 = d->t0;
+    h.t1 = d->t1;
+    h.k = d->k;
+    h.max_bypass = d->max_bypass;
+    h.area_time = d->area_time;
+    h.next_id = d->jobs;
+    h.events = d->events;
+    h.dispatches = d->dispatches;
+    h.steals = d->steals;
+    h.migrations = d->migrations;
+    h.cpu_charged = d->cpu_charged;
+    h.cpu_consumed = d->cpu_consumed;
+    h.cpu_error = d->cpu_error;
+    h.requested_area = d->requested_area;
+    h.allocated_area = d->allocated_area;
+    memcpy(h.wait_hist, d->wait_hist, sizeof(h.wait_hist));
+    h.admission = d->admission;
+    h.metrics = d->metrics;
+    h.mem_stats = *d->mem_stats;
+    put(&h, sizeof(h));
+
+    for (int i = 0; i < d->cpus; i++)
+    {
+        CpuSlot* slot = &d->slots[i];
+        CheckpointSlot r;
+        memset(&r, 0, sizeof(r));
+        r.level = slot->level;
+        r.slice_start = slot->slice_start;
+        r.slice_end = slot->slice_end;
+        r.slice_length = slot->slice_length;
+        r.exited = slot->exited;
+        r.completed = slot->completed;
+        r.turnaround_time = slot->turnaround_time;
+        r.wait_time = slot->wait_time;
+        put(&r, sizeof(r));
+    }
+
+    put_queue(d, &d->job_queue, CHECKPOINT_JOB_QUEUE, -1, 0);
+    put_queue(d, &d->arrived_queue, CHECKPOINT_ARRIVED, -1, 0);
+    for (int level = 0; level < LEVELS; level++)
+    {
+        if (d->layout == QUEUES_SHARED)
+            put_queue(d, &d->level_queue[level], CHECKPOINT_LEVEL, -1, level);
+        else
+            for (int i = 0; i < d->cpus; i++)
+                put_queue(d, &d->slots[i].local[level], CHECKPOINT_LEVEL, i, level);
+    }
+    for (int i = 0; i < d->cpus; i++)
+    {
+        PcbQueue running = { d->slots[i].process, d->slots[i].process, 1 };
+        if (running.head)
+            put_queue(d, &running, CHECKPOINT_RUNNING, i, d->slots[i].level);
+    }
+    put(free_offsets, h.free_blocks * sizeof(int32_t));
+
+    flush_out();
+    if (fsync(out.fd) == -1)
+        out.failed = TRUE;
+    if (close(out.fd) == -1)
+        out.failed = TRUE;
+    if (out.failed || rename(tmp, path) == -1)
+    {
+        unlink(tmp);
+        return FALSE;
+    }
+
+    // make the rename itself durable: sync the directory holding 'path'
+    while (len > 0 && path[len - 1] != '/')
+        len--;
+    if (len == 0)
+        memcpy(dir, ".", 2);
+    else
+    {
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+    }
+    if ((fd = open(dir, O_RDONLY | O_DIRECTORY | O_CLOEXEC)) != -1)
+    {
+        fsync(fd);
+        close(fd);
+    }
+    return TRUE;
+}
+
+// reap the writer of the last snapshot, waiting for it if 'wait';
+// FALSE if it is still writing
+static int reap_writer(DispatcherPtr d, int wait)
+{
+    int status;
+    pid_t pid;
+
+    if (!d->checkpoint_writer)
+        return TRUE;
+    while ((pid = waitpid(d->checkpoint_writer, &status, wait ? 0 : WNOHANG)) == -1 && errno == EINTR)
+        ;
+    if (pid == 0)
+        return FALSE;
+    if (pid == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        fprintf(stderr, "ERROR: Could not write snapshot \"%s\"\n", d->checkpoint_path);
+    d->checkpoint_writer = 0;
+    return TRUE;
+}
+
+/*******************************************************
+ * static helpers - restoring a snapshot
+ ******************************************************/
+
+// read all of 'path' into a malloc'd buffer, NULL on error (reported)
+static char * read_image(const char * path, size_t * size)
+{
+    struct stat st;
+    char * image = NULL;
+    size_t done = 0;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1 || fstat(fd, &st) == -1
+        || !(image = (char *)malloc(st.st_size ? st.st_size : 1)))
+    {
+        fprintf(stderr, "ERROR: Could not read snapshot \"%s\"\n", path);
+        if (fd != -1)
+            close(fd);
+        return NULL;
+    }
+    while (done < (size_t)st.st_size)
+    {
+        ssize_t n = read(fd, image + done, st.st_size - done);
+        if (n <= 0 && !(n == -1 && errno == EINTR))
+        {
+            fprintf(stderr, "ERROR: Could not read snapshot \"%s\"\n", path);
+            close(fd);
+            free(image);
+            return NULL;
+        }
+        if (n > 0)
+            done += n;
+    }
+    close(fd);
+    *size = done;
+    return image;
+}
+
+// recreate the job of record 'r' and put it where it was
+static PcbPtr restore_job(DispatcherPtr d, CheckpointJob * r)
+{
+    PcbPtr p = createnullPcb();
+
+    if (!p)
+        return NULL;
+    p->id = r->id;
+    p->pid = r->pid;
+    p->arrival_time = r->arrival_time;
+    p->start_time = r->start_time;
+    p->service_time = r->service_time;
+    p->remaining_cpu_time = r->remaining_cpu_time;
+    p->status = r->status;
+    p->max_iterations = r->max_iterations;
+    p->curr_iterations = r->curr_iterations;
+    p->mem_size = r->mem_size;
+    p->bypass_count = r->bypass_count;
+    p->cpu = r->cpu;
+    p->first_start_time = r->first_start_time;
+    p->preemptions = r->preemptions;
+    p->quantum_left = r->quantum_left;
+    p->cpu_used_us = r->cpu_used_us;
+    p->cpu_charged_us = r->cpu_charged_us;
+
+    if (r->mem_offset >= 0)
+    {
+        p->mem_block = memAllocAt(d->first_block, d->first_block->offset + r->mem_offset, r->mem_size);
+        if (!p->mem_block || p->mem_block->size != r->mem_block_size)
+        {
+            fprintf(stderr, "ERROR: The memory of job %d overlaps another job's\n", r->id);
+            return NULL;
+        }
+    }
+
+    switch (r->queue)
+    {
+        case CHECKPOINT_JOB_QUEUE:
+            enqPcbQ(&d->job_queue, p);
+            return p;
+        case CHECKPOINT_ARRIVED:
+            enqPcbQ(&d->arrived_queue, p);
+            return p;
+        case CHECKPOINT_LEVEL:
+            if (r->level < 0 || r->level >= LEVELS || r->slot >= d->cpus
+                || (r->slot < 0) != (d->layout == QUEUES_SHARED))
+                break;
+            enqPcbQ(r->slot < 0 ? &d->level_queue[r->level] : &d->slots[r->slot].local[r->level], p);
+            d->queued[r->level]++;
+            return p;
+        case CHECKPOINT_RUNNING:
+            if (r->slot < 0 || r->slot >= d->cpus || d->slots[r->slot].process)
+                break;
+            d->slots[r->slot].process = p;
+            d->pids[r->slot] = p->pid;
+            d->busy++;
+            wheelArm(&d->timers, &d->slots[r->slot].slice_timer, d->slots[r->slot].slice_end);
+            return p;
+    }
+    fprintf(stderr, "ERROR: Job %d has no place in the dispatcher\n", r->id);
+    return NULL;
+}
+
+/*******************************************************
+ * int checkpointInit(DispatcherPtr d, const char * path,
+ *    int every) - have 'd' snapshot itself to 'path' when
+ *    SIGUSR1 is received and, unless 'every' is 0, every
+ *    'every' time units from now
+ *
+ * In real time the reactor takes SIGUSR1 from its signalfd
+ * instead of the handler installed here.
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int checkpointInit(DispatcherPtr d, const char * path, int every)
+{
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sigusr1;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGUSR1, &sa, NULL) == -1)
+    {
+        perror("ERROR: Could not catch SIGUSR1");
+        return FALSE;
+    }
+    d->checkpoint_path = path;
+    d->checkpoint_every = every;
+    d->next_checkpoint = every > PCB_TIME_MAX - d->timer ? INT_MAX : d->timer + every;
+    return TRUE;
+}
+
+/*******************************************************
+ * void checkpointRequest() - take a snapshot at the start
+ *    of the next dispatch step
+ ******************************************************/
+void checkpointRequest(void)
+{
+    requested = TRUE;
+}
+
+/*******************************************************
+ * int checkpointDue(DispatcherPtr d) - TRUE if a snapshot
+ *    was asked for, or the next periodic one is due
+ ******************************************************/
+int checkpointDue(DispatcherPtr d)
+{
+    return requested || (d->checkpoint_every && d->timer >= d->next_checkpoint);
+}
+
+/*******************************************************
+ * int checkpointWrite(DispatcherPtr d) - snapshot 'd' to
+ *    d->checkpoint_path from a forked child
+ *
+ * If the child writing the last snapshot has not finished,
+ * nothing is done and the snapshot stays due.
+ *
+ * returns:
+ *    TRUE if a writer was started
+ *    FALSE if not (errors are reported on stderr)
+ ******************************************************/
+int checkpointWrite(DispatcherPtr d)
+{
+    pid_t pid;
+
+    if (!reap_writer(d, FALSE))
+        return FALSE;
+
+    requested = FALSE;
+    if (d->checkpoint_every)
+        d->next_checkpoint = d->checkpoint_every > PCB_TIME_MAX - d->timer ? INT_MAX
+            : d->timer + d->checkpoint_every;
+    if ((pid = fork()) == -1)
+    {
+        perror("ERROR: Could not start the snapshot writer");
+        return FALSE;
+    }
+    if (pid == 0)
+        _exit(write_snapshot(d, d->checkpoint_path) ? EXIT_SUCCESS : EXIT_FAILURE);
+    d->checkpoint_writer = pid;
+    d->checkpoints++;
+    return TRUE;
+}
+
+/*******************************************************
+ * void checkpointFinish(DispatcherPtr d) - wait until the
+ *    last snapshot has been written (a failure is reported
+ *    on stderr)
+ ******************************************************/
+void checkpointFinish(DispatcherPtr d)
+{
+    reap_writer(d, TRUE);
+}
+
+/*******************************************************
+ * int checkpointRestore(DispatcherPtr d, const char * path,
+ *    int simulate) - set up 'd' as the dispatcher that
+ *    wrote snapshot 'path' was when it took it
+ *
+ * Takes the place of initDispatcher, loading the job list
+ * and setting t0, t1 and k. 'simulate' must match the run
+ * the snapshot came from. In real time, the processes of
+ * the old dispatcher that still run are taken over, and the
+ * caller resumes the reactor clock at d->timer.
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int checkpointRestore(DispatcherPtr d, const char * path, int simulate)
+{
+    struct timespec start, end;
+    size_t size;
+    int adopted = 0, restarted = 0;
+    char * image;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (!(image = read_image(path, &size)))
+        return FALSE;
+
+    CheckpointHeader * h = (CheckpointHeader *)image;
+    if (size < sizeof(*h) || memcmp(h->magic, CHECKPOINT_MAGIC, sizeof(h->magic))
+        || h->version != CHECKPOINT_VERSION || h->header_size != sizeof(CheckpointHeader)
+        || h->slot_size != sizeof(CheckpointSlot) || h->job_size != sizeof(CheckpointJob)
+        || h->cpus < 1 || h->cpus > CPU_SLOTS_MAX || h->jobs < 0 || h->free_blocks < 0 || h->free_blocks > MEM_LIMIT
+        || size != sizeof(*h) + (size_t)h->cpus * sizeof(CheckpointSlot) + (size_t)h->jobs * sizeof(CheckpointJob)
+            + (size_t)h->free_blocks * sizeof(int32_t))
+    {
+        fprintf(stderr, "ERROR: \"%s\" is not a snapshot of this dispatcher\n", path);
+        free(image);
+        return FALSE;
+    }
+    CheckpointSlot * slots = (CheckpointSlot *)(h + 1);
+    CheckpointJob * jobs = (CheckpointJob *)(slots + h->cpus);
+    int32_t * free_offsets = (int32_t *)(jobs + h->jobs);
+    if (h->simulate != simulate)
+    {
+        fprintf(stderr, "ERROR: \"%s\" was taken %s --simulate\n", path, h->simulate ? "with" : "without");
+        free(image);
+        return FALSE;
+    }
+    if (!initDispatcher(d, h->cpus, h->layout, h->mem_policy))
+    {
+        free(image);
+        return FALSE;
+    }
+
+    d->simulate = simulate;
+    d->time_unit = h->time_unit;
+    d->accounting = h->accounting;
+    d->timer = h->timer;
+    d->t0 = h->t0;
+    d->t1 = h->t1;
+    d->k = h->k;
+    d->max_bypass = h->max_bypass;
+    d->area_time = h->area_time;
+    d->jobs = h->next_id;
+    d->events = h->events;
+    d->dispatches = h->dispatches;
+    d->steals = h->steals;
+    d->migrations = h->migrations;
+    d->cpu_charged = h->cpu_charged;
+    d->cpu_consumed = h->cpu_consumed;
+    d->cpu_error = h->cpu_error;
+    d->requested_area = h->requested_area;
+    d->allocated_area = h->allocated_area;
+    memcpy(d->wait_hist, h->wait_hist, sizeof(d->wait_hist));
+    d->admission = h->admission;
+    d->metrics = h->metrics;
+    wheelInit(&d->timers, d->timer);
+
+    for (int i = 0; i < d->cpus; i++)
+    {
+        CpuSlot* slot = &d->slots[i];
+        slot->level = slots[i].level;
+        slot->slice_start = slots[i].slice_start;
+        slot->slice_end = slots[i].slice_end;
+        slot->slice_length = slots[i].slice_length;
+        slot->exited = slots[i].exited;
+        slot->completed = slots[i].completed;
+        slot->turnaround_time = slots[i].turnaround_time;
+        slot->wait_time = slots[i].wait_time;
+    }
+
+    for (int j = 0; j < h->jobs; j++)
+    {
+        CheckpointJob * r = &jobs[j];
+        PcbPtr p = restore_job(d, r);
+        if (!p)
+        {
+            free(image);
+            return FALSE;
+        }
+        if (simulate || p->pid <= 0)
+            continue;
+        if (adoptPcb(p, r->start_time_ticks))
+        {
+            adopted++;
+            continue;
+        }
+        // its process is gone: start it afresh, now if it held a slot
+        restarted++;
+        p->cpu_used_us = p->cpu_charged_us = 0;
+        if (r->queue == CHECKPOINT_RUNNING)
+        {
+            startPcb(p);
+            d->pids[r->slot] = p->pid;
+        }
+    }
+    if (!memSetFreeOrder(d->first_block, free_offsets, h->free_blocks))
+    {
+        fprintf(stderr, "ERROR: The free memory of \"%s\" does not match its jobs\n", path);
+        free(image);
+        return FALSE;
+    }
+    *d->mem_stats = h->mem_stats; // counted since the first run, not by the restore
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (logOn(LOG_JOBS))
+    {
+        printf("Restored %d jobs at time %d from \"%s\" in %.2f ms", h->jobs, d->timer, path,
+            (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6);
+        if (!simulate)
+            printf(", %d processes taken over, %d to start again", adopted, restarted);
+        printf("\n");
+    }
+    free(image);
+    return TRUE;
+}
@@ -0,0 +1,89 @@
+/* Dispatcher snapshot include header file for MLQD dispatcher */
+
+#ifndef MLQD_CHECKPOINT
+#define MLQD_CHECKPOINT
+
+/* Include files */
+#include <stdint.h>
+#include "dispatcher.h"
+
+/* Binary snapshot format *************************************
+ *
+ *   header: CheckpointHeader, the dispatcher counters, metrics
+ *           and heap counters
+ *   body:   'cpus' CheckpointSlots, then 'jobs' CheckpointJobs:
+ *           every unfinished job, queue by queue, each queue
+ *           head first, then 'free_blocks' int32_t offsets
+ *           (memFreeOrder)
+ *
+ * All fields are in host byte order and the record sizes are
+ * checked on restore, so a snapshot is only read back by the
+ * build that wrote it. Memory blocks are given by offset from
+ * the start of the heap; the heap is rebuilt by allocating
+ * each of them again there (memAllocAt), and its free lists
+ * are put back in the order they were in.
+ **************************************************************/
+#define CHECKPOINT_MAGIC "MLQDSNP\0"
+#define CHECKPOINT_VERSION 1
+
+/* Where a job was when the snapshot was taken */
+#define CHECKPOINT_JOB_QUEUE 0 // yet to arrive
+#define CHECKPOINT_ARRIVED 1 // waiting for memory
+#define CHECKPOINT_LEVEL 2 // on the 'level' queue of slot 'slot' (-1: the shared queues)
+#define CHECKPOINT_RUNNING 3 // running on slot 'slot'
+
+/* Custom Data Types */
+struct checkpoint_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size; // sizeof(CheckpointHeader)
+    uint32_t slot_size; // sizeof(CheckpointSlot)
+    uint32_t job_size; // sizeof(CheckpointJob)
+    int32_t cpus; // CheckpointSlots that follow
+    int32_t jobs; // CheckpointJobs that follow them
+    int32_t free_blocks; // free block offsets that follow those
+    int32_t layout, mem_policy, time_unit, accounting, simulate;
+    int32_t timer, t0, t1, k, max_bypass, area_time;
+    int32_t next_id; // Dispatcher.jobs
+    int64_t events, dispatches, steals, migrations;
+    int64_t cpu_charged;
+    double cpu_consumed, cpu_error;
+    double requested_area, allocated_area;
+    long wait_hist[MAB_ORDERS][WAIT_BUCKETS];
+    LatencyHist admission;
+    JobMetrics metrics;
+    MabStats mem_stats;
+};
+
+struct checkpoint_slot {
+    int32_t level, slice_start, slice_end, slice_length, exited;
+    int32_t completed;
+    double turnaround_time, wait_time;
+};
+
+struct checkpoint_job {
+    int32_t queue; // CHECKPOINT_*
+    int32_t slot;
+    int32_t level;
+    int32_t id, pid, arrival_time, start_time, service_time, remaining_cpu_time, status;
+    int32_t max_iterations, curr_iterations, mem_size, bypass_count, cpu;
+    int32_t first_start_time, preemptions, quantum_left;
+    int32_t mem_offset; // from the start of the heap, -1 if the job holds no block
+    int32_t mem_block_size;
+    int64_t cpu_used_us, cpu_charged_us;
+    uint64_t start_time_ticks; // pcbStartTime of 'pid', 0 if it was not running
+};
+
+typedef struct checkpoint_header CheckpointHeader;
+typedef struct checkpoint_slot CheckpointSlot;
+typedef struct checkpoint_job CheckpointJob;
+
+/* Function Prototypes */
+int    checkpointInit(DispatcherPtr d, const char * path, int every); // snapshot to 'path' on SIGUSR1 and every 'every' time units
+void   checkpointRequest(void); // take one at the next step (SIGUSR1)
+int    checkpointDue(DispatcherPtr d); // TRUE if one was asked for or is due
+int    checkpointWrite(DispatcherPtr d); // fork a child that writes one
+void   checkpointFinish(DispatcherPtr d); // wait for the last one to be written
+int    checkpointRestore(DispatcherPtr d, const char * path, int simulate); // initDispatcher from a snapshot
+
+#endif
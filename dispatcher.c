@@ -0,0 +1,841 @@
+/* Scheduling loop of the MLQD dispatcher
+
+   Jobs move job_queue -> Arrived Queue -> (memory allocated) Level-0
+   -> Level-1 (after t0) -> Level-2 (after k rounds of t1). Every CPU
+   slot runs one job at a time; an idle slot takes the oldest job of the
+   highest non-empty level. With QUEUES_PER_CPU each slot has its own
+   Level-0/1/2 queues: a job it suspends stays on them, and an idle slot
+   with nothing of that level steals from the tail of a peer's queue.
+
+   A job admitted to Level-0 with no idle slot pre-empts a Level-2 job,
+   else a Level-1 job, straight away. A pre-empted Level-1 job keeps the
+   rest of its quantum for when it is resumed; the cut-short part does
+   not count as one of its k rounds.
+
+   With an intake (intake.h), jobs submitted while the dispatcher runs
+   join the Arrived Queue on its next step, arriving at the current
+   time, and the dispatcher keeps running until the intake is closed.
+
+   job_queue may be in any order: before the run it is put in arrival
+   order (ties in job id order) through a min-heap, so a step only looks
+   at its head. Slice ends and the next arrival are kept on a timing
+   wheel (wheel.h), so a step only touches the slots whose quantum is
+   over and the jobs that arrive, however many are running or yet to
+   come.
+
+   In real time a job is charged the wall-clock time it held its slot,
+   whether or not its process got a CPU. With ACCOUNT_CPU it is charged
+   the CPU time the process consumed instead, and a slice whose process
+   has consumed less than its length is extended, up to
+   ACCOUNT_STRETCH_MAX times that length in wall time. A process that
+   mostly sleeps is charged at least wall / ACCOUNT_STRETCH_MAX, so it
+   still finishes. Either way the CPU time every process consumed is
+   reported next to what it was charged.
+
+   With a snapshot file (checkpoint.h) the state is written out at the
+   top of a step, when SIGUSR1 was received or every checkpoint_every
+   time units, by a forked child; a restored dispatcher carries on from
+   that step.
+
+   All times are whole units of d->time_unit (seconds by default), which
+   only matters in real time: it scales the reactor deadlines.
+*/
+
+/* Include Files */
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "dispatcher.h"
+#include "reactor.h"
+#include "trace.h"
+#include "intake.h"
+#include "checkpoint.h"
+#include "jobfile.h"
+
+static const char * time_unit_names[TIME_UNITS] = { "s", "ms", "us" };
+static const char * time_unit_long_names[TIME_UNITS] = { "seconds", "milliseconds", "microseconds" };
+static const double time_unit_seconds[TIME_UNITS] = { 1.0, 1e-3, 1e-6 };
+
+/***    HELPERS (used by the user functions below)    ***/
+
+// record_wait - add the Arrived Queue wait of an admitted job to the histogram
+static void record_wait(Dispatcher* d, PcbPtr process)
+{
+    int wait = d->timer - process->arrival_time;
+    int bucket = 0;
+    while (bucket < WAIT_BUCKETS - 1 && wait >= (1 << bucket))
+        bucket++;
+    d->wait_hist[memOrder(process->mem_size)][bucket]++;
+    recordHist(&d->admission, wait);
+}
+
+// enq_job - enqueue 'process' at 'level' on the queues of 'slot'
+static void enq_job(Dispatcher* d, CpuSlot* slot, int level, PcbPtr process)
+{
+    enqPcbQ(&slot->queues[level], process);
+    d->queued[level]++;
+}
+
+// admit_slot - slot whose queues a newly admitted job joins:
+//              the least loaded one when every slot has its own queues
+static CpuSlot* admit_slot(Dispatcher* d)
+{
+    CpuSlot* best = &d->slots[0];
+    int best_load = INT_MAX;
+
+    if (d->layout == QUEUES_SHARED)
+        return best;
+    for (int i = 0; i < d->cpus; i++)
+    {
+        CpuSlot* slot = &d->slots[i];
+        int load = (slot->process != NULL);
+        for (int level = 0; level < LEVELS; level++)
+            load += slot->local[level].count;
+        if (load < best_load)
+        {
+            best = slot;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+// arrives_before - heap order of jobs yet to arrive: by arrival time, then id
+static int arrives_before(PcbPtr a, PcbPtr b)
+{
+    return a->arrival_time < b->arrival_time
+        || (a->arrival_time == b->arrival_time && a->id < b->id);
+}
+
+// sift_down - restore the min-heap of 'count' jobs in 'heap' below position 'i'
+static void sift_down(PcbPtr * heap, int count, int i)
+{
+    PcbPtr process = heap[i];
+
+    while (2 * i + 1 < count)
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < count && arrives_before(heap[child + 1], heap[child]))
+            child++;
+        if (!arrives_before(heap[child], process))
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = process;
+}
+
+// order_arrivals - put job_queue in arrival order (ties by id) once, before the run,
+//                  through a min-heap built bottom-up, unless it is in order already
+static int order_arrivals(Dispatcher* d)
+{
+    PcbPtr * heap;
+    PcbPtr process;
+    int count = 0;
+
+    for (process = d->job_queue.head; process && process->next; process = process->next)
+        if (arrives_before(process->next, process))
+            break;
+    if (!process || !process->next)
+        return TRUE;
+
+    heap = (PcbPtr *)malloc(d->job_queue.count * sizeof(PcbPtr));
+    if (!heap)
+    {
+        fprintf(stderr, "ERROR: Could not allocate arrival heap for %d jobs\n", d->job_queue.count);
+        return FALSE;
+    }
+    while ((process = deqPcbQ(&d->job_queue)))
+        heap[count++] = process;
+    for (int i = count / 2 - 1; i >= 0; i--)
+        sift_down(heap, count, i);
+    while (count)
+    {
+        enqPcbQ(&d->job_queue, heap[0]);
+        heap[0] = heap[--count];
+        if (count)
+            sift_down(heap, count, 0);
+    }
+    free(heap);
+    return TRUE;
+}
+
+// cpu_used - ACCOUNT_CPU: time units of CPU the job on 'slot' consumed that have not
+//            been charged yet, counted from the process's last CPU time sample
+static int cpu_used(Dispatcher* d, CpuSlot* slot)
+{
+    long tick_us = (long)(time_unit_seconds[d->time_unit] * 1e6);
+    return (int)((slot->process->cpu_used_us - slot->process->cpu_charged_us) / tick_us);
+}
+
+// extend_slice - ACCOUNT_CPU: the wall-clock slice of 'slot' is over but its process
+//                has consumed less CPU than the slice length: run it on for what is
+//                owed, until ACCOUNT_STRETCH_MAX slice lengths have passed. TRUE if extended.
+static int extend_slice(Dispatcher* d, CpuSlot* slot)
+{
+    long long limit = slot->slice_start + (long long)slot->slice_length * ACCOUNT_STRETCH_MAX;
+    int owed;
+
+    if (limit > PCB_TIME_MAX)
+        limit = PCB_TIME_MAX;
+    samplePcbCpu(slot->process);
+    owed = slot->slice_length - cpu_used(d, slot);
+    if (owed <= 0 || d->timer >= limit)
+        return FALSE;
+    slot->slice_end = (int)(d->timer + (long long)owed < limit ? d->timer + owed : limit);
+    wheelArm(&d->timers, &slot->slice_timer, slot->slice_end);
+    return TRUE;
+}
+
+/***    USER FUNCTIONS (to reduce repeated code)    ***/
+
+// 1. job_arrival - moves every job that has 'arrived' by now, and every job
+//                  submitted since the last step, to the Arrived Queue
+static int job_arrival(Dispatcher* d)
+{
+    int arrived = 0;
+    IntakeJobPtr job;
+
+    // Dequeue every ready process from job_queue, and enqueue it to the arrived_queue
+    while (d->job_queue.head && d->job_queue.head->arrival_time <= d->timer) {
+        PcbPtr process = deqPcbQ(&d->job_queue);
+        enqPcbQ(&d->arrived_queue, process);
+        traceEvent(TRACE_ARRIVAL, process, 0, 0, d->timer, 0, 0);
+        arrived++;
+    }
+    if (arrived && d->job_queue.head)
+        wheelArm(&d->timers, &d->arrival_timer, d->job_queue.head->arrival_time);
+
+    // Submitted jobs arrive now
+    while (d->intake && (job = intakePop(d->intake))) {
+        JobRecord record = { d->timer, job->service_time, job->mem_size };
+        PcbPtr process = enqJobRecord(&d->arrived_queue, &record, d->jobs++);
+        free(job);
+        if (!process)
+            exit(EXIT_FAILURE);
+        traceEvent(TRACE_ARRIVAL, process, 0, 0, d->timer, 0, 0);
+        arrived++;
+    }
+    return arrived;
+}
+
+// 2. allocate_job - allocate memory for arrived jobs and enqueue them to the Level0_queue.
+//                   Jobs behind a blocked head-of-line job are backfilled if they fit,
+//                   until the blocked job has been bypassed 'max_bypass' times.
+static int allocate_job(Dispatcher* d)
+{
+    int admitted = 0;
+    PcbQueue blocked; // jobs that did not fit, in arrival order
+    initPcbQ(&blocked);
+
+    while (d->arrived_queue.head)
+    {
+        // Stop backfilling once the oldest blocked job has used up its bypass budget
+        if (blocked.head && (blocked.head->bypass_count >= d->max_bypass
+            || blocked.count >= BACKFILL_WINDOW))
+            break;
+
+        PcbPtr process = deqPcbQ(&d->arrived_queue);
+
+        MabPtr allocated_block = memAlloc(d->first_block, process->mem_size);
+        if (!allocated_block) {
+            enqPcbQ(&blocked, process);
+            continue;
+        }
+
+        if (blocked.head)
+            blocked.head->bypass_count++;
+        process->mem_block = allocated_block;
+        traceEvent(TRACE_MEM_ALLOC, process, 0, 0, d->timer,
+            allocated_block->offset - d->first_block->offset, allocated_block->size);
+        traceEvent(TRACE_ADMIT, process, 0, 0, d->timer, 0, 0);
+        enq_job(d, admit_slot(d), 0, process);
+        record_wait(d, process);
+        if (logOn(LOG_MEMORY) && !logOn(LOG_TREE)) {
+            if (!admitted)
+                logPrintf("\n");
+            printMemChanges(d->first_block);
+        }
+        admitted++;
+    }
+
+    // Allocation failed - put blocked processes back at head of queue
+    splicePcbQ(&d->arrived_queue, &blocked);
+
+    if (admitted && logOn(LOG_TREE)) {
+        logPrintf("\n");
+        print_mem_info(d->first_block);
+    }
+    return admitted;
+}
+
+// 3. take_job - dequeue the oldest job of 'level' from the queues of 'slot',
+//               or steal the newest one from the peer with the longest queue
+static PcbPtr take_job(Dispatcher* d, CpuSlot* slot, int level)
+{
+    PcbQueuePtr victim = NULL;
+    PcbPtr process;
+
+    if (slot->queues[level].head)
+        process = deqPcbQ(&slot->queues[level]);
+    else
+    {
+        for (int i = 0; i < d->cpus; i++)
+            if (!victim || d->slots[i].local[level].count > victim->count)
+                victim = &d->slots[i].local[level];
+        process = popPcbQ(victim);
+        d->steals++;
+    }
+    d->queued[level]--;
+    return process;
+}
+
+// 4. start_job - run the next job of queue 'level' on 'slot'
+//                for one quantum (Level-2 jobs run until done or pre-empted)
+static void start_job(Dispatcher* d, CpuSlot* slot, int level)
+{
+    PcbPtr process = take_job(d, slot, level);
+    int cpu = (int)(slot - d->slots);
+    int slice = process->remaining_cpu_time;
+
+    int quantum = level == 0 ? d->t0 : process->quantum_left ? process->quantum_left : d->t1;
+
+    if (level < 2 && slice > quantum)
+        slice = quantum;
+    if (slice < 1)
+        slice = 1; // a job is charged at least one time unit
+    if (slice > PCB_TIME_MAX - d->timer)
+        slice = PCB_TIME_MAX - d->timer; // the run stops there (see vii.)
+    process->quantum_left = 0;
+
+    if (process->cpu != -1 && process->cpu != cpu)
+        d->migrations++;
+    if (process->first_start_time == -1)
+        process->first_start_time = d->timer;
+    process->cpu = cpu;
+    process->start_time = d->timer;
+    slot->process = process;
+    slot->level = level;
+    slot->slice_start = d->timer;
+    slot->slice_end = d->timer + slice;
+    slot->slice_length = slice;
+    slot->exited = FALSE;
+    d->busy++;
+    d->dispatches++;
+
+    // If already started but suspended, restart it (send SIGCONT to it)
+    // else start it (spawn or take a pooled worker)
+    startPcb(process);
+    d->pids[cpu] = process->pid;
+    wheelArm(&d->timers, &slot->slice_timer, slot->slice_end);
+    traceEvent(TRACE_DISPATCH, process, level, cpu, d->timer, 0, 0);
+}
+
+// 5. charge_job - take the time 'slot' ran since it was last charged off its job:
+//                 the wall-clock time, or with ACCOUNT_CPU the CPU time its process
+//                 consumed (at least wall / ACCOUNT_STRETCH_MAX). Returns the time charged.
+static int charge_job(Dispatcher* d, CpuSlot* slot)
+{
+    PcbPtr process = slot->process;
+    int ran = d->timer - slot->slice_start;
+
+    if (d->accounting == ACCOUNT_CPU && !d->simulate)
+    {
+        long tick_us = (long)(time_unit_seconds[d->time_unit] * 1e6);
+        int least = ran / ACCOUNT_STRETCH_MAX;
+
+        samplePcbCpu(process);
+        ran = cpu_used(d, slot);
+        process->cpu_charged_us += ran * tick_us; // the part of a time unit left over is charged later
+        if (ran < least)
+        {
+            ran = least;
+            process->cpu_charged_us = process->cpu_used_us;
+        }
+    }
+    process->remaining_cpu_time -= ran;
+    slot->slice_start = d->timer;
+
+    // The process finished before its service time ran out:
+    // count only the time it ran as its service time
+    if (slot->exited)
+    {
+        slot->process->service_time -= slot->process->remaining_cpu_time;
+        slot->process->remaining_cpu_time = 0;
+    }
+    return ran;
+}
+
+// 6. release_slot - mark 'slot' idle once its process is suspended or terminated
+static void release_slot(Dispatcher* d, CpuSlot* slot)
+{
+    slot->process = NULL;
+    slot->exited = FALSE;
+    d->pids[slot - d->slots] = 0;
+    wheelCancel(&d->timers, &slot->slice_timer);
+    d->busy--;
+}
+
+// 7. terminate_job - ensures proper termination of a finished job
+static void terminate_job(Dispatcher* d, CpuSlot* slot) {
+    PcbPtr process = slot->process;
+
+    // A. Terminate the process
+    terminatePcb(process);
+
+    // B. Calculate and accumulate turnaround time and wait time
+    int turnaround_time = d->timer - process->arrival_time;
+    slot->turnaround_time += turnaround_time;
+    slot->wait_time += turnaround_time - process->service_time;
+    slot->completed++;
+    recordJob(&d->metrics, process, slot->level, d->timer);
+
+    //    and the CPU time it consumed (from wait4) against the time it was charged
+    double consumed = d->simulate ? process->service_time
+        : process->cpu_used_us / (time_unit_seconds[d->time_unit] * 1e6);
+    d->cpu_charged += process->service_time;
+    d->cpu_consumed += consumed;
+    if (process->service_time)
+        d->cpu_error += fabs(process->service_time - consumed) / process->service_time;
+    if (d->job_log)
+        fprintf(d->job_log, "%d,%d,%d,%d,%d,%d,%d,%d,%d,%.6f\n", process->arrival_time,
+            process->service_time, process->mem_size, turnaround_time,
+            turnaround_time - process->service_time, process->first_start_time - process->arrival_time,
+            process->preemptions, slot->level, (int)(slot - d->slots), consumed);
+
+    traceEvent(TRACE_TERMINATE, process, slot->level, (int)(slot - d->slots), d->timer, 0, 0);
+
+    // C. Deallocate the PCB's memory
+    traceEvent(TRACE_MEM_FREE, process, slot->level, (int)(slot - d->slots), d->timer,
+        process->mem_block->offset - d->first_block->offset, process->mem_block->size);
+    memFree(process->mem_block);
+    if (logOn(LOG_TREE)) {
+        logPrintf("\n");
+        print_mem_info(d->first_block);
+    }
+    else if (logOn(LOG_MEMORY)) {
+        logPrintf("\n");
+        printMemChanges(d->first_block);
+    }
+
+    freePcb(process);
+    release_slot(d, slot);
+}
+
+// 8. end_slice - the quantum of the job on 'slot' is over (or the job exited):
+//                terminate it, or suspend it and move it down the queue levels
+static void end_slice(Dispatcher* d, CpuSlot* slot)
+{
+    PcbPtr process = slot->process;
+
+    if (d->accounting == ACCOUNT_CPU && !d->simulate && !slot->exited && extend_slice(d, slot))
+        return;
+
+    // A. Decrement the process's remaining_cpu_time by the time it ran
+    charge_job(d, slot);
+
+    // B. A Level-1 job has completed another iteration
+    if (slot->level == 1)
+        process->curr_iterations += 1;
+
+    // C. If the process's allocated time has expired, terminate it
+    if (process->remaining_cpu_time <= 0)
+    {
+        terminate_job(d, slot);
+        return;
+    }
+
+    // D. Else suspend it and enqueue it to the next queue of this slot:
+    //      Level-0 -> Level-1, Level-1 -> Level-1 until k iterations, then Level-2
+    suspendPcb(process);
+    process->preemptions++;
+    if (slot->level == 0)
+    {
+        process->max_iterations = d->k;
+        traceEvent(TRACE_DEMOTE_L1, process, 1, (int)(slot - d->slots), d->timer, 0, 0);
+        enq_job(d, slot, 1, process);
+    }
+    else if (slot->level == 1 && process->curr_iterations < process->max_iterations)
+    {
+        traceEvent(TRACE_SUSPEND, process, 1, (int)(slot - d->slots), d->timer, 0, 0);
+        enq_job(d, slot, 1, process);
+    }
+    else
+    {
+        traceEvent(TRACE_DEMOTE_L2, process, 2, (int)(slot - d->slots), d->timer, 0, 0);
+        enq_job(d, slot, 2, process);
+    }
+    release_slot(d, slot);
+}
+
+// 9. preempt_jobs - suspend Level-2 jobs, then Level-1 jobs, and put them at head of
+//                   their queue, until every job waiting at Level-0 has a free slot.
+//                   A Level-1 job keeps the rest of its quantum for later.
+static void preempt_jobs(Dispatcher* d)
+{
+    int waiting = d->queued[0] - (d->cpus - d->busy);
+
+    for (int level = 2; level >= 1; level--)
+    {
+        for (int i = d->cpus - 1; i >= 0 && waiting > 0; i--)
+        {
+            CpuSlot* slot = &d->slots[i];
+            if (!slot->process || slot->level != level)
+                continue;
+
+            int ran = charge_job(d, slot);
+            if (slot->process->remaining_cpu_time <= 0)
+                terminate_job(d, slot); // ran out exactly now (or exited)
+            else
+            {
+                if (level == 1 && ran < slot->slice_length)
+                    slot->process->quantum_left = slot->slice_length - ran;
+                suspendPcb(slot->process);
+                slot->process->preemptions++;
+                traceEvent(TRACE_PREEMPT, slot->process, level, i, d->timer, 0, 0);
+                pushPcbQ(&slot->queues[level], slot->process);
+                d->queued[level]++;
+                release_slot(d, slot);
+            }
+            waiting--;
+        }
+    }
+}
+
+// 10. advance_timer - let dispatcher time pass (real or virtual) until the next event:
+//                     the end of a running quantum or the next job arrival.
+//                     In real time the wait ends early if a running process exits,
+//                     a job is submitted or SIGUSR1 asks for a snapshot.
+//                     Returns FALSE if no event is left to wait for.
+static int advance_timer(Dispatcher* d)
+{
+    int next = wheelNext(&d->timers);
+
+    if (next == INT_MAX && !(d->intake && intakeOpen(d->intake)))
+        return FALSE;
+
+    if (d->simulate)
+    {
+        d->timer = next;
+        return TRUE;
+    }
+
+    refillSpawnPool(); // off the dispatch path, just before blocking
+    double tick = time_unit_seconds[d->time_unit];
+    int woken = reactorWait(next == INT_MAX ? -1.0 : next * tick, d->pids, d->cpus);
+    if (woken == REACTOR_TIMEOUT)
+    {
+        d->timer = next;
+        return TRUE;
+    }
+    if (woken == REACTOR_USER_SIGNAL)
+        checkpointRequest();
+
+    // A process finished before its quantum ran out, a job was submitted or a
+    // snapshot asked for: charge running processes up to the current time unit
+    double now = ceil(reactorElapsed() / tick);
+    if (now > PCB_TIME_MAX)
+        now = PCB_TIME_MAX; // the run stops there (see vii.)
+    d->timer = now > next ? next : now < d->timer ? d->timer : (int)now;
+    for (int i = 0; i < d->cpus; i++)
+    {
+        CpuSlot* slot = &d->slots[i];
+        if (slot->process && reactorExited(slot->process->pid))
+        {
+            slot->exited = TRUE;
+            slot->slice_end = d->timer;
+            wheelArm(&d->timers, &slot->slice_timer, d->timer);
+        }
+    }
+    return TRUE;
+}
+
+/*******************************************************
+ * int initDispatcher(DispatcherPtr d, int cpus, int layout,
+ *    int mem_policy) - set up an idle dispatcher with 'cpus'
+ *      CPU slots, empty queues and MEM_LIMIT megabytes of
+ *      memory managed by allocation policy 'mem_policy'
+ *
+ * The caller fills job_queue, in any order, and sets t0,
+ * t1 and k before calling runDispatcher.
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int initDispatcher(DispatcherPtr d, int cpus, int layout, int mem_policy)
+{
+    memset(d, 0, sizeof(Dispatcher));
+    initPcbQ(&d->job_queue);
+    initPcbQ(&d->arrived_queue);
+    for (int level = 0; level < LEVELS; level++)
+        initPcbQ(&d->level_queue[level]);
+    d->cpus = cpus;
+    d->layout = layout;
+    d->mem_policy = mem_policy;
+    d->max_bypass = BACKFILL_MAX_BYPASS;
+
+    // Initialise global memory of 2048 megabytes
+    d->memory = malloc(MEM_LIMIT); /* assume this refers to megabytes.
+                                      if this were real it would be malloc(2 * 1024^3) */
+    d->slots = (CpuSlot *)calloc(cpus, sizeof(CpuSlot));
+    d->pids = (pid_t *)calloc(cpus, sizeof(pid_t));
+    d->due = (uint64_t *)calloc((cpus + 63) / 64, sizeof(uint64_t));
+    if (!d->memory || !d->slots || !d->pids || !d->due)
+    {
+        fprintf(stderr, "ERROR: Could not allocate dispatcher\n");
+        closeDispatcher(d);
+        return FALSE;
+    }
+    if (!(d->first_block = memInitPolicy(mem_policy, (uintptr_t)d->memory, MEM_LIMIT)))
+    {
+        closeDispatcher(d);
+        return FALSE;
+    }
+    d->mem_stats = memStats(d->first_block);
+    wheelInit(&d->timers, 0);
+    wheelTimerInit(&d->arrival_timer, NULL);
+
+    for (int i = 0; i < cpus; i++)
+    {
+        CpuSlot* slot = &d->slots[i];
+        wheelTimerInit(&slot->slice_timer, slot);
+        for (int level = 0; level < LEVELS; level++)
+            initPcbQ(&slot->local[level]);
+        slot->queues = layout == QUEUES_PER_CPU ? slot->local : d->level_queue;
+    }
+    return TRUE;
+}
+
+/*******************************************************
+ * int runDispatcher(DispatcherPtr d) - run every job on
+ *    job_queue to completion
+ *
+ * returns:
+ *    TRUE when all jobs have finished
+ *    FALSE if jobs were left that can never be allocated
+ *    memory, or on error (already reported on stderr)
+ ******************************************************/
+int runDispatcher(DispatcherPtr d)
+{
+    if (!order_arrivals(d))
+        return FALSE;
+    if (d->job_queue.head)
+        wheelArm(&d->timers, &d->arrival_timer, d->job_queue.head->arrival_time);
+
+//  3. Dispatch loop, run once per scheduling event (quantum end or job arrival)
+    while (1)
+    {
+        // Snapshot the state this step starts from, if asked for or due (checkpoint.c)
+        if (d->checkpoint_path && checkpointDue(d))
+            checkpointWrite(d);
+
+        d->events++;
+        d->requested_area += (double)d->mem_stats->requested * (d->timer - d->area_time);
+        d->allocated_area += (double)d->mem_stats->allocated * (d->timer - d->area_time);
+        d->area_time = d->timer;
+
+//      i. End the quantum of every process whose time-quantum expired (or that exited):
+//              terminate it, or suspend it and enqueue it to the next queue level
+//              (in slot order, the order the queues are fed in)
+        for (WheelTimerPtr t = wheelExpire(&d->timers, d->timer); t; t = t->next)
+        {
+            int i = t->data ? (int)((CpuSlot *)t->data - d->slots) : -1;
+            if (i >= 0)
+                d->due[i / 64] |= 1ULL << (i % 64);
+        }
+        for (int word = 0; word < (d->cpus + 63) / 64; word++)
+            for (; d->due[word]; d->due[word] &= d->due[word] - 1)
+                end_slice(d, &d->slots[word * 64 + __builtin_ctzll(d->due[word])]);
+
+//      ii. Terminate MLQD Dispatcher if there are no jobs left to run (or to be submitted)
+        if (!(d->job_queue.head || d->arrived_queue.head || d->queued[0]
+            || d->queued[1] || d->queued[2] || d->busy
+            || (d->intake && intakeOpen(d->intake))))
+            return TRUE;
+
+//      iii. Move every job that has 'arrived' to the Arrived Queue
+        job_arrival(d);
+
+//      iv. Dequeue every job in Arrived Queue that memory can be allocated for,
+//              in arrival order, and add it to Level-0 Queue
+//              (submitters are held back while too many jobs wait for memory)
+        allocate_job(d);
+        if (d->intake)
+            intakeSetBacklog(d->intake, d->arrived_queue.count);
+
+//      v. Level-0 jobs without an idle slot pre-empt Level-2 jobs, then Level-1 jobs
+        if (d->queued[0])
+            preempt_jobs(d);
+
+//      vi. Start a job on every idle slot, taking from
+//              4. Level-0 Queue: High Priority First-Come-First-Served,
+//              5. Level-1 Queue: Round-Robin, then
+//              6. Level-2 Queue: Low Priority First-Come-First-Served
+//              (the highest level with a waiting job anywhere goes first; slots
+//              holding such a job on their own queues start before slots steal)
+        for (int pass = 0; pass < 2; pass++)
+        {
+            for (int i = 0; i < d->cpus && d->busy < d->cpus; i++)
+            {
+                int level = 0;
+                if (d->slots[i].process)
+                    continue;
+                while (level < LEVELS && !d->queued[level])
+                    level++;
+                if (level == LEVELS)
+                    break;
+                if (pass == 0 && !d->slots[i].queues[level].head)
+                    continue;
+                start_job(d, &d->slots[i], level);
+            }
+        }
+
+//      vii. Sleep until the next quantum ends or job arrives and advance the dispatcher timer
+//              (an idle dispatcher jumps straight to the next arrival), unless the timer
+//              cannot count any further
+        if (d->timer >= PCB_TIME_MAX)
+        {
+            fprintf(stderr, "ERROR: Dispatcher time reached its limit of %d %s with jobs left\n",
+                PCB_TIME_MAX, time_unit_long_names[d->time_unit]);
+            return FALSE;
+        }
+        if (!advance_timer(d))
+        {
+            fprintf(stderr, "ERROR: %d jobs in the Arrived Queue can never be allocated memory\n",
+                d->arrived_queue.count);
+            return FALSE;
+        }
+
+//      go back to 3.
+    }
+}
+
+/*******************************************************
+ * void printWaitHist(DispatcherPtr d) - print the Arrived
+ *    Queue wait histogram per memory size class
+ ******************************************************/
+void printWaitHist(DispatcherPtr d)
+{
+    printf("\nArrived Queue wait (%s) by memory size class:\n", time_unit_long_names[d->time_unit]);
+    printf("%8s %7s", "mem MB", "jobs");
+    for (int b = 0; b < WAIT_BUCKETS; b++)
+    {
+        char label[16];
+        if (b == 0)
+            sprintf(label, "0");
+        else if (b == WAIT_BUCKETS - 1)
+            sprintf(label, "%d+", 1 << (b - 1));
+        else if (b == 1)
+            sprintf(label, "1");
+        else
+            sprintf(label, "%d-%d", 1 << (b - 1), (1 << b) - 1);
+        printf(" %7s", label);
+    }
+    printf("\n");
+
+    for (int order = 0; order < MAB_ORDERS; order++)
+    {
+        long jobs = 0;
+        for (int b = 0; b < WAIT_BUCKETS; b++)
+            jobs += d->wait_hist[order][b];
+        if (!jobs)
+            continue;
+        printf("%8d %7ld", BLOCK_MIN_SIZE << order, jobs);
+        for (int b = 0; b < WAIT_BUCKETS; b++)
+            printf(" %7ld", d->wait_hist[order][b]);
+        printf("\n");
+    }
+}
+
+/*******************************************************
+ * void printMemUsage(DispatcherPtr d) - print how long
+ *    jobs waited in the Arrived Queue for memory and how
+ *    much of it they held on average over the run: asked
+ *    for, and given once rounded up by the policy
+ ******************************************************/
+void printMemUsage(DispatcherPtr d)
+{
+    LatencyHistPtr a = &d->admission;
+    double capacity = (double)MEM_LIMIT * (d->timer ? d->timer : 1);
+
+    printf("Admission delay: mean %.3f, p50 %ld, p99 %ld, max %ld\n",
+        a->count ? a->sum / a->count : 0.0, percentileHist(a, 50), percentileHist(a, 99), a->max);
+    printf("Memory utilization: requested %.1f%%, allocated %.1f%%\n",
+        100.0 * d->requested_area / capacity, 100.0 * d->allocated_area / capacity);
+}
+
+/*******************************************************
+ * void printCpuAccounting(DispatcherPtr d) - print the time
+ *    finished jobs were charged against the CPU time their
+ *    processes consumed (nothing when simulated)
+ ******************************************************/
+void printCpuAccounting(DispatcherPtr d)
+{
+    int jobs = 0;
+
+    if (d->simulate)
+        return;
+    for (int i = 0; i < d->cpus; i++)
+        jobs += d->slots[i].completed;
+    printf("CPU time (%s accounting): charged %ld, consumed %.3f, mean error per job %.1f%%\n",
+        d->accounting == ACCOUNT_CPU ? "cpu" : "wall clock", d->cpu_charged, d->cpu_consumed,
+        jobs ? 100.0 * d->cpu_error / jobs : 0.0);
+}
+
+/*******************************************************
+ * void closeDispatcher(DispatcherPtr d) - release the
+ *    slots and memory of a dispatcher
+ ******************************************************/
+void closeDispatcher(DispatcherPtr d)
+{
+    memClose(d->first_block);
+    free(d->slots);
+    free(d->pids);
+    free(d->due);
+    free(d->memory);
+    d->first_block = NULL;
+    d->slots = NULL;
+    d->pids = NULL;
+    d->due = NULL;
+    d->memory = NULL;
+}
+
+/*******************************************************
+ * int parseTimeUnit(int * unit, const char * name) -
+ *    look up a time unit by name: s, ms or us
+ *
+ * returns:
+ *    TRUE and sets *unit if 'name' is known
+ *    FALSE otherwise
+ ******************************************************/
+int parseTimeUnit(int * unit, const char * name)
+{
+    for (int i = 0; i < TIME_UNITS; i++)
+    {
+        if (strcmp(time_unit_names[i], name) == 0)
+        {
+            *unit = i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*******************************************************
+ * const char * timeUnitName(int unit) - "seconds",
+ *    "milliseconds" or "microseconds"
+ ******************************************************/
+const char * timeUnitName(int unit)
+{
+    return time_unit_long_names[unit];
+}
+
+/*******************************************************
+ * double timeUnitSeconds(int unit) - length of one unit
+ ******************************************************/
+double timeUnitSeconds(int unit)
+{
+    return time_unit_seconds[unit];
+}
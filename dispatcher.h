@@ -0,0 +1,118 @@
+/* Dispatcher include header file for MLQD dispatcher */
+
+#ifndef MLQD_DISPATCHER
+#define MLQD_DISPATCHER
+
+/* Include files */
+#include "pcb.h"
+#include "mab.h"
+#include "metrics.h"
+#include "wheel.h"
+
+/* Scheduling Definitions *************************************/
+#define BACKFILL_MAX_BYPASS 8 // default times a blocked job may be bypassed
+#define BACKFILL_WINDOW 32 // blocked jobs looked past when backfilling
+#define WAIT_BUCKETS 9 // wait histogram buckets: 0, 1, 2-3, ... 64-127, 128+
+#define CPU_SLOTS_MAX 1024
+
+/* Queue layouts */
+#define QUEUES_SHARED 0 // one set of Level-0/1/2 queues for all CPU slots
+#define QUEUES_PER_CPU 1 // a set per slot, idle slots steal from their peers
+
+/* Time units of the job times, quanta and dispatcher timer */
+#define TIME_S 0 // seconds, the default
+#define TIME_MS 1 // milliseconds
+#define TIME_US 2 // microseconds
+#define TIME_UNITS 3
+
+/* What a real process is charged for the time it holds a CPU slot */
+#define ACCOUNT_WALL 0 // the wall-clock time it held the slot, the default
+#define ACCOUNT_CPU 1 // the CPU time it consumed (wait4, /proc/<pid>/schedstat)
+#define ACCOUNT_STRETCH_MAX 4 // ACCOUNT_CPU: a slice lasts at most this many times its
+                              // length in wall time, and is charged at least wall / this
+
+/* Custom Data Types */
+
+/* One CPU slot: the process it runs and the slice it was given */
+struct cpu_slot {
+    PcbPtr process; // NULL while the slot is idle
+    int level; // queue level 'process' was dispatched from
+    int slice_start; // time 'process' was last charged up to
+    int slice_end; // time its quantum runs out
+    int slice_length; // time units the slice was given
+    int exited; // TRUE if 'process' exited before 'slice_end'
+    WheelTimer slice_timer; // armed for 'slice_end' while 'process' runs
+    PcbQueuePtr queues; // Level-0/1/2 queues this slot takes work from first
+    PcbQueue local[LEVELS]; // its own queues when QUEUES_PER_CPU
+    int completed; // jobs finished on this slot
+    double turnaround_time; // summed over those jobs
+    double wait_time;
+};
+
+typedef struct cpu_slot CpuSlot;
+
+/* Dispatcher state: queues, memory and CPU slots */
+struct dispatcher {
+    PcbQueue job_queue; // jobs to run, in any order until runDispatcher sorts it
+    PcbQueue arrived_queue; // blocked processes are pushed back to its head
+    PcbQueue level_queue[LEVELS]; // shared queues, pre-empted processes are pushed
+                                  // back to the head of Level-2
+    int queued[LEVELS]; // jobs waiting at each level, over all queue sets
+    MabPtr first_block;
+    MabStatsPtr mem_stats; // live counters of the heap first_block heads
+    int mem_policy; // MEM_* allocation policy of that heap
+    void * memory;
+    CpuSlot * slots;
+    pid_t * pids; // child running on each slot, 0 if none, for the reactor
+    uint64_t * due; // scratch bitmap of slots whose quantum is over
+    Wheel timers; // slice ends, and the next arrival
+    WheelTimer arrival_timer;
+    int cpus; // number of slots
+    int layout; // QUEUES_SHARED or QUEUES_PER_CPU
+    int busy; // slots running a process
+    int simulate; // TRUE: virtual clock, no child processes are run
+    int time_unit; // TIME_*, for real time on the reactor clock
+    int accounting; // ACCOUNT_*, real time only
+    int timer;
+    int t0; // time quantum for Level-0 queue
+    int t1; // time quantum for Level-1 queue
+    int k;  // number of iterations for a job to stay in the Level-1 queue
+    int max_bypass; // 0 is strict first-come-first-served admission
+    long events; // passes through the dispatch loop
+    long dispatches; // jobs started or resumed on a slot
+    long steals; // jobs an idle slot took from a peer's queues
+    long migrations; // suspended jobs resumed on a different slot
+    long wait_hist[MAB_ORDERS][WAIT_BUCKETS]; // Arrived Queue waits by memory size class
+    LatencyHist admission; // Arrived Queue waits of every admitted job
+    double requested_area; // megabyte time units of memory asked for by admitted jobs
+    double allocated_area; // ... and of the blocks they were given
+    int area_time; // time the areas are summed up to
+    struct intake * intake; // online submissions (intake.h), NULL if there are none
+    int jobs; // jobs loaded or submitted so far, the id of the next submitted job
+    long cpu_charged; // time units finished jobs were charged (their service time)
+    double cpu_consumed; // ... and CPU time their processes consumed, in time units
+    double cpu_error; // summed |charged - consumed| / charged of those jobs
+    JobMetrics metrics; // latencies of finished jobs
+    FILE * job_log; // if set, one CSV line per finished job
+    const char * checkpoint_path; // snapshot file (checkpoint.h), NULL if none are taken
+    int checkpoint_every; // time units between snapshots, 0: only on SIGUSR1
+    int next_checkpoint; // time the next periodic snapshot is due
+    pid_t checkpoint_writer; // child writing the last snapshot, 0 once reaped
+    long checkpoints; // snapshots taken
+};
+
+typedef struct dispatcher Dispatcher;
+typedef Dispatcher * DispatcherPtr;
+
+/* Function Prototypes */
+int    initDispatcher(DispatcherPtr, int cpus, int layout, int mem_policy);
+int    runDispatcher(DispatcherPtr);
+void   printWaitHist(DispatcherPtr);
+void   printMemUsage(DispatcherPtr);
+void   printCpuAccounting(DispatcherPtr);
+void   closeDispatcher(DispatcherPtr);
+int    parseTimeUnit(int * unit, const char * name); // "ms" -> TIME_MS
+const char * timeUnitName(int unit); // "milliseconds"
+double timeUnitSeconds(int unit); // 0.001
+
+#endif
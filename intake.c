@@ -0,0 +1,443 @@
+/* Online job submission for MLQD dispatcher
+
+   A listener thread accepts clients on a Unix stream socket and gives
+   each one a thread that parses its "service, mem" lines into
+   IntakeJobs. Those go on a lock-free multi-producer single-consumer
+   list (an intrusive list with a stub node: a push is one atomic
+   exchange plus a store, a pop touches no other thread's cache lines
+   unless the list is nearly empty). An eventfd wakes the dispatcher
+   once per batch of lines read, and the dispatcher pops everything on
+   its next scheduling step.
+
+   Backpressure: the dispatcher reports how many popped jobs are still
+   waiting for memory. While that plus the jobs not yet popped is at
+   max_pending, client threads stop reading, the socket buffers fill
+   up and the clients block in write().
+*/
+
+/* Include Files */
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include "intake.h"
+#include "mab.h"
+#include "pcb.h"
+
+/*******************************************************
+ * static helpers - client side threads
+ ******************************************************/
+
+// append 'job' to the list
+static void link_job(IntakePtr in, IntakeJobPtr job)
+{
+    job->next = NULL;
+    IntakeJobPtr prev = __atomic_exchange_n(&in->head, job, __ATOMIC_ACQ_REL);
+    // until this store the consumer sees the list end at 'prev'
+    __atomic_store_n(&prev->next, job, __ATOMIC_RELEASE);
+}
+
+// TRUE until a client sent "close"
+static int accepting(IntakePtr in)
+{
+    return __atomic_load_n(&in->open, __ATOMIC_ACQUIRE);
+}
+
+// TRUE while clients have to wait for the dispatcher to admit jobs
+static int intake_full(IntakePtr in)
+{
+    return __atomic_load_n(&in->depth, __ATOMIC_RELAXED)
+        + __atomic_load_n(&in->backlog, __ATOMIC_RELAXED) >= in->max_pending;
+}
+
+// hold the calling client back until there is room or the intake closes
+static void wait_for_room(IntakePtr in)
+{
+    __atomic_fetch_add(&in->held, 1, __ATOMIC_RELAXED);
+    intakeWake(in); // what was pushed so far has to be popped first
+    pthread_mutex_lock(&in->lock);
+    __atomic_fetch_add(&in->waiting, 1, __ATOMIC_RELAXED);
+    while (intake_full(in) && accepting(in))
+    {
+        // timed, so a wakeup racing the check above only costs a few ms
+        struct timespec until;
+        clock_gettime(CLOCK_REALTIME, &until);
+        until.tv_nsec += 5000000L;
+        until.tv_sec += until.tv_nsec / 1000000000L;
+        until.tv_nsec %= 1000000000L;
+        pthread_cond_timedwait(&in->space, &in->lock, &until);
+    }
+    __atomic_fetch_sub(&in->waiting, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&in->lock);
+}
+
+// parse one line; FALSE if it is malformed, after "close" *closed is set
+static int parse_line(char * line, IntakeJobPtr job, int * closed)
+{
+    char * c = line;
+    while (*c == ' ' || *c == '\t' || *c == '\r')
+        c++;
+    if (strncmp(c, "close", 5) == 0)
+    {
+        *closed = TRUE;
+        return TRUE;
+    }
+    if (sscanf(c, "%d , %d", &job->service_time, &job->mem_size) != 2
+        || job->service_time < 0 || job->service_time > PCB_TIME_MAX
+        || job->mem_size < 1 || job->mem_size > MEM_LIMIT)
+        return FALSE;
+    return TRUE;
+}
+
+// push a copy of 'job', once there is room; FALSE if the intake has closed
+static int push_job(IntakePtr in, IntakeJob * job)
+{
+    if (!accepting(in))
+        return FALSE;
+    IntakeJobPtr node = (IntakeJobPtr)malloc(sizeof(IntakeJob));
+    if (!node)
+    {
+        fprintf(stderr, "FATAL: malloc() not working");
+        exit(EXIT_FAILURE);
+    }
+    *node = *job;
+    if (intake_full(in))
+        wait_for_room(in);
+    if (intakePush(in, node))
+        return TRUE;
+    free(node);
+    return FALSE;
+}
+
+// read and push the jobs of one client until it disconnects
+static void * client_thread(void * arg)
+{
+    struct intake_client * client = (struct intake_client *)arg;
+    IntakePtr in = client->intake;
+    char buffer[16384];
+    size_t used = 0;
+
+    while (accepting(in))
+    {
+        ssize_t n = read(client->fd, buffer + used, sizeof(buffer) - used);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        used += n;
+
+        char * line = buffer;
+        char * end;
+        int pushed = 0, closed = FALSE;
+        while ((end = memchr(line, '\n', used - (line - buffer))))
+        {
+            IntakeJob job;
+            int close_line = FALSE;
+            *end = '\0';
+            if (end == line)
+                ; // empty line
+            else if (!parse_line(line, &job, &close_line))
+                __atomic_fetch_add(&in->rejected, 1, __ATOMIC_RELAXED);
+            else if (close_line)
+            {
+                intakeClose(in); // also wakes the dispatcher for what was pushed
+                closed = TRUE;
+            }
+            else if (push_job(in, &job))
+                pushed++;
+            else // read before a "close" from any client, but not pushed before it
+                __atomic_fetch_add(&in->rejected, 1, __ATOMIC_RELAXED);
+            line = end + 1;
+        }
+        if (pushed)
+            intakeWake(in);
+        if (closed)
+            break;
+
+        // keep the unfinished line; one that fills the buffer is dropped
+        used -= line - buffer;
+        if (used == sizeof(buffer))
+        {
+            __atomic_fetch_add(&in->rejected, 1, __ATOMIC_RELAXED);
+            used = 0;
+        }
+        memmove(buffer, line, used);
+    }
+
+    __atomic_store_n(&client->done, TRUE, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// join a finished client thread and free its slot
+static void reap_client(struct intake_client * client)
+{
+    pthread_join(client->thread, NULL);
+    close(client->fd);
+    client->fd = -1;
+    client->done = FALSE;
+}
+
+// accept clients until the listening socket is shut down
+static void * listener_thread(void * arg)
+{
+    IntakePtr in = (IntakePtr)arg;
+
+    while (1)
+    {
+        int fd = accept(in->listen_fd, NULL, NULL);
+        if (fd == -1)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            break; // shut down by intakeDestroy
+        }
+
+        struct intake_client * slot = NULL;
+        for (int i = 0; i < INTAKE_CLIENTS_MAX; i++)
+        {
+            struct intake_client * client = &in->clients[i];
+            if (client->fd != -1 && __atomic_load_n(&client->done, __ATOMIC_ACQUIRE))
+                reap_client(client);
+            if (client->fd == -1 && !slot)
+                slot = client;
+        }
+        if (!slot)
+        {
+            close(fd); // too many clients
+            continue;
+        }
+        slot->fd = fd;
+        slot->done = FALSE;
+        slot->intake = in;
+        if (pthread_create(&slot->thread, NULL, client_thread, slot) != 0)
+        {
+            close(fd);
+            slot->fd = -1;
+        }
+    }
+    return NULL;
+}
+
+/*******************************************************
+ * IntakePtr intakeCreate(long max_pending) - create an
+ *    empty, open intake; see intakeListen to take jobs
+ *    from clients
+ *
+ * returns:
+ *    IntakePtr of the new intake
+ *    NULL on error (already reported on stderr)
+ ******************************************************/
+IntakePtr intakeCreate(long max_pending)
+{
+    IntakePtr in = (IntakePtr)calloc(1, sizeof(Intake));
+    if (!in)
+    {
+        fprintf(stderr, "ERROR: Could not allocate the job intake\n");
+        return NULL;
+    }
+    if ((in->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1)
+    {
+        perror("ERROR: Could not create the job intake");
+        free(in);
+        return NULL;
+    }
+    in->head = in->tail = &in->stub;
+    in->max_pending = max_pending;
+    in->open = TRUE;
+    in->listen_fd = -1;
+    pthread_mutex_init(&in->lock, NULL);
+    pthread_cond_init(&in->space, NULL);
+    for (int i = 0; i < INTAKE_CLIENTS_MAX; i++)
+        in->clients[i].fd = -1;
+    return in;
+}
+
+/*******************************************************
+ * int intakeListen(IntakePtr in, const char * path) -
+ *    accept clients on a new Unix stream socket at 'path'
+ *    (replacing a stale one) from a listener thread
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int intakeListen(IntakePtr in, const char * path)
+{
+    if (strlen(path) >= sizeof(in->address.sun_path))
+    {
+        fprintf(stderr, "ERROR: Socket path \"%s\" is too long\n", path);
+        return FALSE;
+    }
+    memset(&in->address, 0, sizeof(in->address));
+    in->address.sun_family = AF_UNIX;
+    strcpy(in->address.sun_path, path);
+    unlink(path);
+
+    if ((in->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1
+        || bind(in->listen_fd, (struct sockaddr *)&in->address, sizeof(in->address)) == -1
+        || listen(in->listen_fd, INTAKE_CLIENTS_MAX) == -1)
+    {
+        fprintf(stderr, "ERROR: Could not listen on \"%s\": %s\n", path, strerror(errno));
+        return FALSE;
+    }
+    if (pthread_create(&in->listener, NULL, listener_thread, in) != 0)
+    {
+        fprintf(stderr, "ERROR: Could not start the job intake\n");
+        close(in->listen_fd);
+        in->listen_fd = -1;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*******************************************************
+ * int intakePush(IntakePtr in, IntakeJobPtr job) - add
+ *    'job' to the intake; any number of threads may push
+ *    at once, the intake frees the job once popped
+ *
+ * The job is counted in 'depth' before the intake is seen
+ * to be open, and linked after that, so a consumer that
+ * finds it closed with nothing left (intakeOpen) cannot
+ * miss a job being pushed.
+ *
+ * returns:
+ *    TRUE if the job was added
+ *    FALSE if the intake has closed, 'job' is not taken
+ ******************************************************/
+int intakePush(IntakePtr in, IntakeJobPtr job)
+{
+    __atomic_fetch_add(&in->depth, 1, __ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&in->open, __ATOMIC_SEQ_CST))
+    {
+        __atomic_fetch_sub(&in->depth, 1, __ATOMIC_SEQ_CST);
+        intakeWake(in); // the consumer may have seen it counted, and waits for it
+        return FALSE;
+    }
+    link_job(in, job);
+    __atomic_fetch_add(&in->submitted, 1, __ATOMIC_RELAXED);
+    return TRUE;
+}
+
+/*******************************************************
+ * void intakeWake(IntakePtr in) - make the intake's
+ *    eventfd readable, e.g. after pushing a batch of jobs
+ ******************************************************/
+void intakeWake(IntakePtr in)
+{
+    uint64_t one = 1;
+    ssize_t rc = write(in->wake_fd, &one, sizeof(one));
+    (void)rc; // only fails if the counter would overflow, it is readable then anyway
+}
+
+/*******************************************************
+ * IntakeJobPtr intakePop(IntakePtr in) - take the oldest
+ *    job off the intake; only one thread may pop
+ *
+ * returns:
+ *    the job, to be freed by the caller
+ *    NULL if there is none, or the newest one is still
+ *    being pushed (its producer wakes the consumer after)
+ ******************************************************/
+IntakeJobPtr intakePop(IntakePtr in)
+{
+    IntakeJobPtr tail = in->tail;
+    IntakeJobPtr next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    if (tail == &in->stub)
+    {
+        if (!next)
+            return NULL;
+        in->tail = tail = next;
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    }
+    if (!next)
+    {
+        // 'tail' is the last job: put the stub behind it so it can be taken
+        if (tail != __atomic_load_n(&in->head, __ATOMIC_ACQUIRE))
+            return NULL;
+        link_job(in, &in->stub);
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+        if (!next)
+            return NULL;
+    }
+    in->tail = next;
+    __atomic_fetch_sub(&in->depth, 1, __ATOMIC_RELAXED);
+    return tail;
+}
+
+/*******************************************************
+ * void intakeSetBacklog(IntakePtr in, long backlog) -
+ *    consumer: 'backlog' popped jobs are still waiting for
+ *    memory; held back clients go on once there is room
+ ******************************************************/
+void intakeSetBacklog(IntakePtr in, long backlog)
+{
+    __atomic_store_n(&in->backlog, backlog, __ATOMIC_RELAXED);
+    if (__atomic_load_n(&in->waiting, __ATOMIC_RELAXED) && !intake_full(in))
+    {
+        pthread_mutex_lock(&in->lock);
+        pthread_cond_broadcast(&in->space);
+        pthread_mutex_unlock(&in->lock);
+    }
+}
+
+/*******************************************************
+ * int intakeOpen(IntakePtr in) - TRUE until a client sent
+ *    "close", and after that while jobs are left to pop
+ ******************************************************/
+int intakeOpen(IntakePtr in)
+{
+    // in this order, against intakePush's, see there
+    return __atomic_load_n(&in->open, __ATOMIC_SEQ_CST)
+        || __atomic_load_n(&in->depth, __ATOMIC_SEQ_CST) > 0;
+}
+
+/*******************************************************
+ * void intakeClose(IntakePtr in) - accept no more jobs;
+ *    held back clients and the consumer are woken up
+ ******************************************************/
+void intakeClose(IntakePtr in)
+{
+    __atomic_store_n(&in->open, FALSE, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&in->lock);
+    pthread_cond_broadcast(&in->space);
+    pthread_mutex_unlock(&in->lock);
+    intakeWake(in);
+}
+
+/*******************************************************
+ * void intakeDestroy(IntakePtr in) - close the intake,
+ *    stop its threads, remove its socket and free the
+ *    jobs that were never popped
+ ******************************************************/
+void intakeDestroy(IntakePtr in)
+{
+    IntakeJobPtr job;
+
+    if (!in)
+        return;
+    intakeClose(in);
+    if (in->listen_fd != -1)
+    {
+        shutdown(in->listen_fd, SHUT_RDWR); // accept() returns
+        pthread_join(in->listener, NULL);
+        close(in->listen_fd);
+        unlink(in->address.sun_path);
+    }
+    for (int i = 0; i < INTAKE_CLIENTS_MAX; i++)
+    {
+        if (in->clients[i].fd == -1)
+            continue;
+        shutdown(in->clients[i].fd, SHUT_RDWR); // read() returns
+        reap_client(&in->clients[i]);
+    }
+    while ((job = intakePop(in)))
+        free(job);
+    close(in->wake_fd);
+    pthread_mutex_destroy(&in->lock);
+    pthread_cond_destroy(&in->space);
+    free(in);
+}
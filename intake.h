@@ -0,0 +1,88 @@
+/* Online job submission include header file for MLQD dispatcher */
+
+#ifndef MLQD_INTAKE
+#define MLQD_INTAKE
+
+/* Include files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sys/un.h>
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+/* Submission protocol ****************************************
+ *
+ * Clients connect to the Unix stream socket and write one line
+ * per job, "service, mem" (mem 1 to MEM_LIMIT megabytes, other
+ * lines are counted as rejected), which arrives when the
+ * dispatcher reads it. A "close" line stops the intake: the dispatcher
+ * finishes the jobs it has and exits. Nothing is sent back;
+ * when too many jobs wait for memory the intake stops reading,
+ * so the clients' writes block.
+ **************************************************************/
+#define INTAKE_MAX_PENDING 4096 // default jobs submitted but not admitted before clients are held back
+#define INTAKE_CLIENTS_MAX 64 // connections served at once
+#define INTAKE_LINE_MAX 128
+
+/* Custom Data Types */
+struct intake_job {
+    struct intake_job * next;
+    int service_time;
+    int mem_size;
+};
+
+struct intake_client {
+    pthread_t thread;
+    int fd; // -1 while the slot is free
+    int done; // the thread has finished, join it and close 'fd'
+    struct intake * intake;
+};
+
+/* Multi-producer single-consumer job list: client threads push with
+   one atomic exchange, the dispatcher pops without taking a lock */
+struct intake {
+    struct intake_job * head; // newest job, producers swap themselves in here
+    struct intake_job * tail; // oldest job, consumer only
+    struct intake_job stub; // keeps the list non-empty
+    long depth; // jobs being pushed or pushed, and not yet popped
+    long backlog; // popped jobs still waiting for memory, set by the consumer
+    long max_pending; // depth + backlog at which clients are held back
+    long submitted; // jobs pushed so far
+    long rejected; // malformed lines, jobs that could never run (0 MB, over MEM_LIMIT)
+                   // and jobs read but not pushed before a client's "close"
+    long held; // times a client was held back
+    int open; // FALSE once a client sent "close"
+    int wake_fd; // eventfd, readable once jobs were pushed or the intake closed
+    int listen_fd;
+    struct sockaddr_un address;
+    pthread_t listener;
+    pthread_mutex_t lock; // only for holding clients back
+    pthread_cond_t space;
+    int waiting; // clients held back
+    struct intake_client clients[INTAKE_CLIENTS_MAX];
+};
+
+typedef struct intake_job IntakeJob;
+typedef IntakeJob * IntakeJobPtr;
+typedef struct intake Intake;
+typedef Intake * IntakePtr;
+
+/* Function Prototypes */
+IntakePtr  intakeCreate(long max_pending); // the job list only, no socket
+int        intakeListen(IntakePtr in, const char * path); // serve clients on Unix socket 'path'
+int        intakePush(IntakePtr in, IntakeJobPtr job); // producers: lock free, FALSE once closed
+void       intakeWake(IntakePtr in); // producers: wake the consumer after pushing
+IntakeJobPtr intakePop(IntakePtr in); // consumer: oldest job, NULL if none
+void       intakeSetBacklog(IntakePtr in, long backlog); // consumer: let clients go on once there is room
+int        intakeOpen(IntakePtr in); // TRUE until "close", or while jobs are left to pop
+void       intakeClose(IntakePtr in); // stop accepting jobs
+void       intakeDestroy(IntakePtr in); // close, stop the threads and remove the socket
+
+#endif
@@ -0,0 +1,64 @@
+/*
+    jobconv - convert a text job list to the binary job list format
+
+    usage:
+        ./jobconv <TEXTFILE> <BINFILE>
+        where <TEXTFILE> is a job list of "arrival, service, mem" lines
+        (test1/test2 style) and <BINFILE> is the binary list to write
+*/
+
+/* Include files */
+#include "jobfile.h"
+
+int main(int argc, char *argv[])
+{
+    FILE * input_list_stream;
+    JobRecord * records = NULL;
+    int count = 0, capacity = 0;
+    int arrival_time, service_time, mem_size;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "Usage: %s <TEXTFILE> <BINFILE>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (!(input_list_stream = fopen(argv[1], "r")))
+    {
+        fprintf(stderr, "ERROR: Could not open \"%s\"\n", argv[1]);
+        exit(EXIT_FAILURE);
+    }
+
+    while (!feof(input_list_stream))
+    {
+        if (fscanf(input_list_stream, "%d, %d, %d", &arrival_time, &service_time, &mem_size) != 3)
+            continue;
+
+        if (arrival_time < 0 || service_time < 0 || mem_size < 0 || mem_size > MEM_LIMIT)
+        {
+            fprintf(stderr, "ERROR: Job file %s has invalid entries.\n", argv[1]);
+            exit(EXIT_FAILURE);
+        }
+
+        if (count == capacity)
+        {
+            capacity = capacity ? 2 * capacity : 1024;
+            if (!(records = (JobRecord *)realloc(records, capacity * sizeof(JobRecord))))
+            {
+                fprintf(stderr, "FATAL: Could not allocate job records\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+        records[count].arrival_time = arrival_time;
+        records[count].service_time = service_time;
+        records[count].mem_size = mem_size;
+        count++;
+    }
+    fclose(input_list_stream);
+
+    if (!writeBinJobList(argv[2], records, count))
+        exit(EXIT_FAILURE);
+
+    free(records);
+    exit(EXIT_SUCCESS);
+}
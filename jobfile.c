@@ -0,0 +1,214 @@
+/* Job list loading functions for MLQD dispatcher */
+
+/* Include Files */
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "jobfile.h"
+
+/*******************************************************
+ * static helpers
+ ******************************************************/
+
+// create an initialised Pcb for one job and put it on 'queue'; 'entry' and
+// 'number' say where in 'path' the job came from ("line" 3, "record" 7)
+static int enq_job(PcbQueuePtr queue, int arrival_time, int service_time, int mem_size,
+    char * path, const char * entry, long number)
+{
+    if (arrival_time < 0 || service_time < 0 || service_time > PCB_TIME_MAX - arrival_time
+        || mem_size < 1 || mem_size > MEM_LIMIT)
+    {
+        fprintf(stderr, "ERROR: Job file %s has an invalid entry at %s %ld: \"%d, %d, %d\" "
+            "(times must be >= 0 and end by %d, memory 1 to %d MB).\n", path, entry, number,
+            arrival_time, service_time, mem_size, PCB_TIME_MAX, MEM_LIMIT);
+        return FALSE;
+    }
+
+    JobRecord record = { arrival_time, service_time, mem_size };
+    return enqJobRecord(queue, &record, queue->count) != NULL;
+}
+
+/*******************************************************
+ * PcbPtr enqJobRecord(PcbQueuePtr queue, const JobRecord * record, int id)
+ *    - create an initialised Pcb for the job in 'record',
+ *      numbered 'id', and put it at the tail of 'queue'
+ *
+ * The record is not checked: callers that read it from
+ * outside (job files) validate it first.
+ *
+ * returns:
+ *    PcbPtr of the queued process
+ *    NULL if no Pcb could be created
+ ******************************************************/
+PcbPtr enqJobRecord(PcbQueuePtr queue, const JobRecord * record, int id)
+{
+    PcbPtr process = createnullPcb();
+    if (!process)
+        return NULL;
+    process->id = id;
+    process->arrival_time = record->arrival_time;
+    process->service_time = record->service_time;
+    process->remaining_cpu_time = record->service_time;
+    process->mem_size = record->mem_size;
+    process->status = PCB_INITIALIZED;
+    enqPcbQ(queue, process);
+    return process;
+}
+
+// text job list: one "arrival, service, mem" line per job, in any order;
+// jobs are queued in file order and the dispatcher orders them by arrival
+static int load_text(FILE * stream, char * path, PcbQueuePtr queue)
+{
+    int arrival_time, service_time, mem_size;
+    char * line = NULL;
+    size_t size = 0;
+    long number = 0;
+    int n = 0;
+
+    while (getline(&line, &size, stream) != -1)
+    {
+        number++;
+        if (sscanf(line, "%d, %d, %d", &arrival_time, &service_time, &mem_size) != 3)
+            continue;
+        if (!enq_job(queue, arrival_time, service_time, mem_size, path, "line", number))
+        {
+            free(line);
+            return -1;
+        }
+        n++;
+    }
+    free(line);
+    return n;
+}
+
+// binary job list: header followed by fixed-width records, queued in
+// file order like a text list, sorted (JOBFILE_SORTED) or not
+static int load_binary(const char * map, size_t length, char * path, PcbQueuePtr queue)
+{
+    const JobFileHeader * header = (const JobFileHeader *)map;
+    const JobRecord * records = (const JobRecord *)(map + sizeof(JobFileHeader));
+
+    if (header->version != JOBFILE_VERSION || header->count > INT_MAX
+        || length - sizeof(JobFileHeader) < header->count * sizeof(JobRecord))
+    {
+        fprintf(stderr, "ERROR: Job file %s is not a valid binary job list.\n", path);
+        return -1;
+    }
+
+    int n = (int)header->count;
+    if (!initPcbPool(n))
+        return -1;
+
+    for (int i = 0; i < n; i++)
+        if (!enq_job(queue, records[i].arrival_time, records[i].service_time,
+                records[i].mem_size, path, "record", i + 1))
+            return -1;
+    return n;
+}
+
+/*******************************************************
+ * int loadJobList(char * path, PcbQueuePtr queue)
+ *    - load a job list into 'queue'
+ *
+ * Binary job lists (see jobfile.h) are mapped into memory
+ * and read without stdio, anything else is parsed as a
+ * text "arrival, service, mem" list. Either is queued in
+ * file order (runDispatcher does not need it sorted).
+ *
+ * returns:
+ *    number of jobs loaded
+ *    -1 on error (already reported on stderr)
+ ******************************************************/
+int loadJobList(char * path, PcbQueuePtr queue)
+{
+    int fd = open(path, O_RDONLY);
+    struct stat st;
+    char magic[sizeof(((JobFileHeader *)0)->magic)];
+    int n;
+
+    if (fd == -1 || fstat(fd, &st) == -1)
+    {
+        fprintf(stderr, "ERROR: Could not open \"%s\"\n", path);
+        if (fd != -1)
+            close(fd);
+        return -1;
+    }
+
+    if ((size_t)st.st_size >= sizeof(JobFileHeader)
+        && pread(fd, magic, sizeof(magic), 0) == (ssize_t)sizeof(magic)
+        && memcmp(magic, JOBFILE_MAGIC, sizeof(magic)) == 0)
+    {
+        char * map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        close(fd);
+        if (map == MAP_FAILED)
+        {
+            fprintf(stderr, "ERROR: Could not map \"%s\"\n", path);
+            return -1;
+        }
+        madvise(map, st.st_size, MADV_SEQUENTIAL);
+        n = load_binary(map, st.st_size, path, queue);
+        munmap(map, st.st_size);
+        return n;
+    }
+
+    FILE * stream = fdopen(fd, "r");
+    if (!stream)
+    {
+        fprintf(stderr, "ERROR: Could not open \"%s\"\n", path);
+        close(fd);
+        return -1;
+    }
+    n = load_text(stream, path, queue);
+    fclose(stream);
+    return n;
+}
+
+/*******************************************************
+ * int writeBinJobList(char * path, JobRecord * records, int count)
+ *    - write 'count' records as a binary job list, flagging
+ *      it as sorted when the records are in arrival order
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int writeBinJobList(char * path, JobRecord * records, int count)
+{
+    JobFileHeader header;
+    FILE * stream;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, JOBFILE_MAGIC, sizeof(header.magic));
+    header.version = JOBFILE_VERSION;
+    header.flags = JOBFILE_SORTED;
+    header.count = count;
+    for (int i = 1; i < count; i++)
+    {
+        if (records[i].arrival_time < records[i - 1].arrival_time)
+        {
+            header.flags &= ~JOBFILE_SORTED;
+            break;
+        }
+    }
+
+    if (!(stream = fopen(path, "wb")))
+    {
+        fprintf(stderr, "ERROR: Could not create \"%s\"\n", path);
+        return FALSE;
+    }
+    if (fwrite(&header, sizeof(header), 1, stream) != 1
+        || fwrite(records, sizeof(JobRecord), count, stream) != (size_t)count)
+    {
+        fprintf(stderr, "ERROR: Could not write \"%s\"\n", path);
+        fclose(stream);
+        return FALSE;
+    }
+    if (fclose(stream) != 0)
+    {
+        fprintf(stderr, "ERROR: Could not write \"%s\"\n", path);
+        return FALSE;
+    }
+    return TRUE;
+}
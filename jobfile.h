@@ -0,0 +1,43 @@
+/* Job list include header file for MLQD dispatcher */
+
+#ifndef MLQD_JOBFILE
+#define MLQD_JOBFILE
+
+/* Include files */
+#include <stdint.h>
+#include "pcb.h"
+
+/* Binary job list format *************************************
+ *
+ *   header: JobFileHeader
+ *   body:   'count' JobRecords
+ *
+ * All fields are in host byte order.
+ **************************************************************/
+#define JOBFILE_MAGIC "MLQDJOB\0" // 8 bytes, never valid in a text job list
+#define JOBFILE_VERSION 1
+#define JOBFILE_SORTED 0x1 // records are in non-decreasing arrival order
+
+/* Custom Data Types */
+struct job_file_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t count; // number of records that follow
+};
+
+struct job_record {
+    int32_t arrival_time;
+    int32_t service_time;
+    int32_t mem_size;
+};
+
+typedef struct job_file_header JobFileHeader;
+typedef struct job_record JobRecord;
+
+/* Function Prototypes */
+int loadJobList(char * path, PcbQueuePtr queue); // load a text or binary job list into 'queue'
+PcbPtr enqJobRecord(PcbQueuePtr queue, const JobRecord * record, int id); // queue an initialised Pcb for 'record'
+int writeBinJobList(char * path, JobRecord * records, int count); // write records as a binary job list
+
+#endif
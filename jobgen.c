@@ -0,0 +1,110 @@
+/*
+    jobgen - generate a synthetic job list
+
+    usage:
+        ./jobgen [--jobs N] [--arrival poisson|bursty|diurnal] [--rate R]
+                 [--burst B] [--period P] [--service exp|pareto] [--mean S]
+                 [--mem small|mixed|large] [--seed N] [--binary] <JOBFILE>
+        where <JOBFILE> is the job list to write, as "arrival, service, mem"
+        lines (test1/test2 style) or, with --binary, as a binary list
+
+        --rate is the mean number of arrivals per second (default 0.5).
+        bursty arrivals come in bursts at B times the rate (default 10),
+        diurnal arrivals swing +-80% around the rate over P seconds
+        (default 3600). --mean is the mean service time in seconds
+        (default 5); pareto service times are heavy tailed. Memory sizes
+        are log-uniform over 1-64 MB (small), 1-1024 MB (mixed, default)
+        or 256-2048 MB (large). The same options and seed always give the
+        same job list.
+*/
+
+/* Include files */
+#include <string.h>
+#include "workload.h"
+
+int main(int argc, char *argv[])
+{
+    Workload w;
+    int binary = FALSE;
+    char * job_file = NULL;
+    char * end = "";
+
+    initWorkload(&w);
+    for (int i = 1; i < argc && *end == '\0'; i++)
+    {
+        int ok = TRUE;
+        if (strcmp(argv[i], "--binary") == 0)
+            binary = TRUE;
+        else if (strncmp(argv[i], "--", 2) != 0)
+        {
+            ok = !job_file;
+            job_file = argv[i];
+        }
+        else if (i + 1 >= argc)
+            ok = FALSE; // option without a value
+        else if (strcmp(argv[i], "--jobs") == 0)
+            w.jobs = (int)strtol(argv[++i], &end, 10);
+        else if (strcmp(argv[i], "--rate") == 0)
+            w.rate = strtod(argv[++i], &end);
+        else if (strcmp(argv[i], "--burst") == 0)
+            w.burst = strtod(argv[++i], &end);
+        else if (strcmp(argv[i], "--period") == 0)
+            w.period = strtod(argv[++i], &end);
+        else if (strcmp(argv[i], "--mean") == 0)
+            w.mean_service = strtod(argv[++i], &end);
+        else if (strcmp(argv[i], "--seed") == 0)
+            w.seed = strtoull(argv[++i], &end, 10);
+        else if (strcmp(argv[i], "--arrival") == 0)
+            ok = parseWorkloadName(&w.arrival, "arrival", argv[++i]);
+        else if (strcmp(argv[i], "--service") == 0)
+            ok = parseWorkloadName(&w.service, "service", argv[++i]);
+        else if (strcmp(argv[i], "--mem") == 0)
+            ok = parseWorkloadName(&w.mem, "mem", argv[++i]);
+        else
+            ok = FALSE;
+        if (!ok)
+            end = "!"; // stop, report usage below
+    }
+    if (!job_file || *end)
+    {
+        fprintf(stderr, "Usage: %s [--jobs N] [--arrival poisson|bursty|diurnal] [--rate R] "
+            "[--burst B] [--period P] [--service exp|pareto] [--mean S] "
+            "[--mem small|mixed|large] [--seed N] [--binary] <JOBFILE>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    JobRecord * records = (JobRecord *)malloc((size_t)w.jobs * sizeof(JobRecord) + 1);
+    if (!records)
+    {
+        fprintf(stderr, "FATAL: Could not allocate job records\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!genWorkload(&w, records))
+        exit(EXIT_FAILURE);
+
+    if (binary)
+    {
+        if (!writeBinJobList(job_file, records, w.jobs))
+            exit(EXIT_FAILURE);
+    }
+    else
+    {
+        FILE * stream = fopen(job_file, "w");
+        if (!stream)
+        {
+            fprintf(stderr, "ERROR: Could not create \"%s\"\n", job_file);
+            exit(EXIT_FAILURE);
+        }
+        for (int i = 0; i < w.jobs; i++)
+            fprintf(stream, "%d, %d, %d\n", records[i].arrival_time,
+                records[i].service_time, records[i].mem_size);
+        if (fclose(stream) != 0)
+        {
+            fprintf(stderr, "ERROR: Could not write \"%s\"\n", job_file);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    free(records);
+    exit(EXIT_SUCCESS);
+}
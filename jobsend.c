@@ -0,0 +1,111 @@
+/*
+    jobsend - submit jobs to a running dispatcher (mlqd --listen)
+
+    usage:
+        ./jobsend [--close] <SOCKET> [JOBFILE...]
+        where each JOBFILE is a text or binary job list; the service
+        time and memory of every job are sent in order, the arrival
+        times are ignored (a submitted job arrives when it is read)
+
+        --close closes the dispatcher's intake after the jobs are sent:
+        it finishes what it has and exits.
+
+    The send blocks while the dispatcher holds submissions back, see
+    intake.h. Prints the jobs sent and the rate they were sent at.
+*/
+
+/* Include files */
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "jobfile.h"
+
+// write all of 'buffer', FALSE if the dispatcher went away
+static int send_all(int fd, const char * buffer, size_t length)
+{
+    while (length)
+    {
+        ssize_t n = send(fd, buffer, length, MSG_NOSIGNAL);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return FALSE;
+        buffer += n;
+        length -= n;
+    }
+    return TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+    struct sockaddr_un address;
+    struct timespec start, end;
+    char buffer[16384];
+    size_t used = 0;
+    long sent = 0;
+    int close_intake = FALSE;
+    int arg = 1;
+    int fd;
+
+    if (arg < argc && strcmp(argv[arg], "--close") == 0)
+    {
+        close_intake = TRUE;
+        arg++;
+    }
+    if (arg >= argc || strlen(argv[arg]) >= sizeof(address.sun_path))
+    {
+        fprintf(stderr, "Usage: %s [--close] <SOCKET> [JOBFILE...]\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, argv[arg]);
+    if ((fd = socket(AF_UNIX, SOCK_STREAM, 0)) == -1
+        || connect(fd, (struct sockaddr *)&address, sizeof(address)) == -1)
+    {
+        fprintf(stderr, "ERROR: Could not connect to \"%s\": %s\n", argv[arg], strerror(errno));
+        exit(EXIT_FAILURE);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (arg++; arg < argc; arg++)
+    {
+        PcbQueue queue;
+        PcbPtr p;
+
+        initPcbQ(&queue);
+        if (loadJobList(argv[arg], &queue) < 0)
+            exit(EXIT_FAILURE);
+        while ((p = deqPcbQ(&queue)))
+        {
+            if (used + 32 > sizeof(buffer))
+            {
+                if (!send_all(fd, buffer, used))
+                {
+                    fprintf(stderr, "ERROR: The dispatcher closed the connection after %ld jobs\n", sent);
+                    exit(EXIT_FAILURE);
+                }
+                used = 0;
+            }
+            used += sprintf(buffer + used, "%d, %d\n", p->service_time, p->mem_size);
+            sent++;
+            freePcb(p);
+        }
+    }
+    if (close_intake)
+        used += sprintf(buffer + used, "close\n");
+    if (used && !send_all(fd, buffer, used))
+    {
+        fprintf(stderr, "ERROR: The dispatcher closed the connection after %ld jobs\n", sent);
+        exit(EXIT_FAILURE);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    close(fd);
+
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%ld jobs sent in %.3f s (%.0f jobs/s)\n", sent, seconds, seconds > 0 ? sent / seconds : 0.0);
+    exit(EXIT_SUCCESS);
+}
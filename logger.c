@@ -0,0 +1,247 @@
+/* Buffered logging for MLQD dispatcher
+
+   Until logStart is called, logPrintf writes straight to stdout. After
+   it, lines are appended to the front of two buffers and a writer
+   thread writes out the back one, so the dispatcher only pays for the
+   formatting and a memcpy. The front buffer is handed over when it is
+   half full, or after LOG_FLUSH_MS so a slow run still shows progress.
+   Nothing is dropped: if both buffers are full, logPrintf waits.
+*/
+
+/* Include Files */
+#include <pthread.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include "logger.h"
+
+int log_level = LOG_MEMORY;
+
+static const char * level_names[] = { "quiet", "jobs", "memory", "tree", NULL };
+
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake; // writer: a buffer was handed over, or flush/stop
+    pthread_cond_t done; // producers: the back buffer has been written
+    pthread_t writer;
+    FILE * out;
+    int running; // TRUE while the writer thread owns the output
+    int flushing, stopping;
+    char * front; // producers append here
+    size_t front_used;
+    char * back; // the writer drains this one
+    size_t back_used; // 0 once written
+} logger = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+/*******************************************************
+ * static helpers - called with logger.lock held
+ ******************************************************/
+
+// hand the front buffer to the writer if the back one is free
+static int hand_over(void)
+{
+    if (logger.back_used || !logger.front_used)
+        return FALSE;
+    char * full = logger.front;
+    logger.front = logger.back;
+    logger.back = full;
+    logger.back_used = logger.front_used;
+    logger.front_used = 0;
+    pthread_cond_signal(&logger.wake);
+    return TRUE;
+}
+
+static void * log_writer(void * arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&logger.lock);
+    while (1)
+    {
+        if (!logger.back_used && !logger.stopping && !(logger.flushing && logger.front_used))
+        {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += LOG_FLUSH_MS * 1000000L;
+            until.tv_sec += until.tv_nsec / 1000000000L;
+            until.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&logger.wake, &logger.lock, &until);
+        }
+        hand_over(); // no-op if a buffer was handed over already
+
+        if (logger.back_used)
+        {
+            // write without the lock, producers keep filling the front buffer
+            size_t used = logger.back_used;
+            pthread_mutex_unlock(&logger.lock);
+            fwrite(logger.back, 1, used, logger.out);
+            fflush(logger.out);
+            pthread_mutex_lock(&logger.lock);
+            logger.back_used = 0;
+            pthread_cond_broadcast(&logger.done);
+        }
+        else if (logger.stopping)
+            break;
+    }
+    pthread_mutex_unlock(&logger.lock);
+    return NULL;
+}
+
+/*******************************************************
+ * void logSetLevel(int level) - log messages up to 'level'
+ ******************************************************/
+void logSetLevel(int level)
+{
+    log_level = level;
+}
+
+/*******************************************************
+ * int parseLogLevel(int * level, const char * name) -
+ *    look up a verbosity level by name
+ *
+ * returns:
+ *    TRUE and sets *level if 'name' is known
+ *    FALSE otherwise
+ ******************************************************/
+int parseLogLevel(int * level, const char * name)
+{
+    for (int i = 0; level_names[i]; i++)
+    {
+        if (strcmp(level_names[i], name) == 0)
+        {
+            *level = i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*******************************************************
+ * int logStart(FILE * out) - buffer everything logged
+ *    from now on and write it to 'out' from a writer thread
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr); logging
+ *    then stays direct
+ ******************************************************/
+int logStart(FILE * out)
+{
+    static int registered = FALSE;
+
+    if (logger.running)
+        return TRUE;
+    if (!(logger.front = (char *)malloc(LOG_BUFFER_SIZE))
+        || !(logger.back = (char *)malloc(LOG_BUFFER_SIZE)))
+    {
+        fprintf(stderr, "ERROR: Could not allocate log buffers\n");
+        free(logger.front);
+        logger.front = NULL;
+        return FALSE;
+    }
+    fflush(out); // whatever was printed before comes first
+    logger.out = out;
+    logger.front_used = logger.back_used = 0;
+    logger.flushing = logger.stopping = FALSE;
+    if (pthread_create(&logger.writer, NULL, log_writer, NULL) != 0)
+    {
+        fprintf(stderr, "ERROR: Could not start the log writer\n");
+        free(logger.front);
+        free(logger.back);
+        logger.front = logger.back = NULL;
+        return FALSE;
+    }
+    logger.running = TRUE;
+    if (!registered)
+        registered = atexit(logStop) == 0; // error exits still write what was logged
+    return TRUE;
+}
+
+/*******************************************************
+ * void logPrintf(const char * format, ...) - log one
+ *    message, printf style; callers check logOn first
+ ******************************************************/
+void logPrintf(const char * format, ...)
+{
+    char line[LOG_LINE_MAX];
+    va_list args;
+
+    va_start(args, format);
+    if (!logger.running)
+    {
+        vprintf(format, args);
+        va_end(args);
+        return;
+    }
+    int n = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (n < 0)
+        return;
+    if (n >= (int)sizeof(line))
+        n = sizeof(line) - 1;
+
+    pthread_mutex_lock(&logger.lock);
+    while (logger.front_used + n > LOG_BUFFER_SIZE)
+    {
+        if (!hand_over())
+            pthread_cond_wait(&logger.done, &logger.lock); // both buffers full
+    }
+    memcpy(logger.front + logger.front_used, line, n);
+    logger.front_used += n;
+    if (logger.front_used >= LOG_BUFFER_SIZE / 2)
+        hand_over();
+    pthread_mutex_unlock(&logger.lock);
+}
+
+/*******************************************************
+ * void logFlush() - return once everything logged so far
+ *    has been written, e.g. before printing on stdout
+ *    directly or forking
+ ******************************************************/
+void logFlush(void)
+{
+    if (!logger.running)
+    {
+        fflush(stdout);
+        return;
+    }
+    pthread_mutex_lock(&logger.lock);
+    logger.flushing = TRUE;
+    pthread_cond_signal(&logger.wake);
+    while (logger.front_used || logger.back_used)
+        pthread_cond_wait(&logger.done, &logger.lock);
+    logger.flushing = FALSE;
+    pthread_mutex_unlock(&logger.lock);
+}
+
+/*******************************************************
+ * void logChild() - after fork, in the child: the writer
+ *    thread was not copied, so write directly from now on
+ ******************************************************/
+void logChild(void)
+{
+    logger.running = FALSE;
+}
+
+/*******************************************************
+ * void logStop() - write out what is left and stop the
+ *    writer thread; logging is direct again afterwards
+ ******************************************************/
+void logStop(void)
+{
+    if (!logger.running)
+        return;
+    pthread_mutex_lock(&logger.lock);
+    logger.stopping = TRUE;
+    pthread_cond_signal(&logger.wake);
+    pthread_mutex_unlock(&logger.lock);
+    pthread_join(logger.writer, NULL);
+
+    logger.running = FALSE;
+    free(logger.front);
+    free(logger.back);
+    logger.front = logger.back = NULL;
+}
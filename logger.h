@@ -0,0 +1,48 @@
+/* Buffered logging include header file for MLQD dispatcher */
+
+#ifndef MLQD_LOGGER
+#define MLQD_LOGGER
+
+/* Include files */
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+/* Verbosity levels, each includes the ones below it */
+#define LOG_QUIET 0 // nothing while the dispatcher runs
+#define LOG_JOBS 1 // a Pcb line whenever a job is started
+#define LOG_MEMORY 2 // the memory blocks every allocation and free changed
+#define LOG_TREE 3 // the whole buddy tree instead, after every change
+
+#define LOG_BUFFER_SIZE (1 << 16) // bytes in each of the two buffers
+#define LOG_LINE_MAX 512 // longer lines are cut short
+#define LOG_FLUSH_MS 100 // longest a line waits in the buffer
+
+extern int log_level; // LOG_MEMORY unless set by logSetLevel
+
+/* Function Prototypes */
+void   logSetLevel(int level);
+int    parseLogLevel(int * level, const char * name); // "quiet", "jobs", "memory" or "tree"
+int    logStart(FILE * out); // buffer from now on, drained to 'out' by a writer thread
+void   logPrintf(const char * format, ...) __attribute__((format(printf, 1, 2)));
+void   logFlush(void); // wait until everything logged so far has been written
+void   logChild(void); // in a forked child: write directly, the writer thread is gone
+void   logStop(void); // flush and stop the writer thread
+
+/*******************************************************
+ * int logOn(int level) - TRUE if messages of 'level' are
+ *    logged; check it before formatting anything costly
+ ******************************************************/
+static inline int logOn(int level)
+{
+    return log_level >= level;
+}
+
+#endif
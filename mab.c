@@ -1,50 +1,395 @@
-/* MAB management functions for MLQD dispatcher */
+/* MAB management functions for MLQD dispatcher
+
+   The helpers and reports up to printMemStats are shared by both buddy
+   heaps. The pointer tree below is the default; building with
+   -DMAB_BITMAP (make MAB=bitmap) uses the flat bitmap heap in
+   mab_bitmap.c instead.
+*/
 
 /* Include Files */
 #include "mab.h"
+#include <time.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static const char * policy_names[MEM_POLICIES] = { "buddy", "segregated", "first-fit", "best-fit" };
+
+/*******************************************************
+ * static helpers - block order
+ ******************************************************/
+
+// order of the smallest block that can hold 'size' megabytes
+static int mab_order(int size)
+{
+    int order = 0;
+    while ((BLOCK_MIN_SIZE << order) < size)
+        order++;
+    return order;
+}
+
+/*******************************************************
+ * uint64_t memCycles() - time stamp counter for the
+ *    latency counters; nanoseconds where there is none
+ ******************************************************/
+uint64_t memCycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/*******************************************************
+ * int memOrder(int size) - order of the block memAlloc would
+ *    use for 'size': 0 for BLOCK_MIN_SIZE ... MAB_ORDERS - 1
+ ******************************************************/
+int memOrder(int size)
+{
+    return mab_order(size);
+}
+
+/*******************************************************
+ * MabPtr memInitPolicy(int policy, int offset, int size)
+ *    - create a heap managed by allocation policy 'policy'
+ *      (MEM_*), see memInit for the parameters
+ *
+ * Every mem* function works on blocks of any policy.
+ ******************************************************/
+MabPtr memInitPolicy(int policy, int offset, int size)
+{
+    return policy == MEM_BUDDY ? memInit(offset, size) : fitInit(policy, offset, size);
+}
+
+/*******************************************************
+ * int parseMemPolicy(int * policy, const char * name)
+ *    - look up an allocation policy by name
+ *
+ * returns:
+ *    TRUE and sets *policy if 'name' is known
+ *    FALSE otherwise
+ ******************************************************/
+int parseMemPolicy(int * policy, const char * name)
+{
+    for (int i = 0; i < MEM_POLICIES; i++)
+    {
+        if (strcmp(policy_names[i], name) == 0)
+        {
+            *policy = i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*******************************************************
+ * const char * memPolicyName(int policy) - name of a
+ *    MEM_* policy, as parseMemPolicy takes it
+ ******************************************************/
+const char * memPolicyName(int policy)
+{
+    return policy >= 0 && policy < MEM_POLICIES ? policy_names[policy] : "unknown";
+}
+
+/*******************************************************
+ * void printMemStats(MabPtr m) - print the allocator
+ *    counters of the heap that block 'm' belongs to
+ *
+ * Internal fragmentation is the share of allocated memory
+ * that was not asked for, external fragmentation the share
+ * of free memory outside the largest free block.
+ ******************************************************/
+void printMemStats(MabPtr m)
+{
+    MabStatsPtr s = memStats(m);
+
+    printf("\nMemory (%s): %ld MB allocated (%ld MB requested, peak %ld MB), %ld MB free, "
+        "largest free block %ld MB\n", memPolicyName(m->policy), s->allocated, s->requested, s->peak_allocated, s->free,
+        s->largest_free);
+    printf("internal fragmentation = %.1f%%, external fragmentation = %.1f%%\n",
+        s->allocated ? 100.0 * (s->allocated - s->requested) / s->allocated : 0.0,
+        s->free ? 100.0 * (s->free - s->largest_free) / s->free : 0.0);
+    printf("memAlloc: %ld allocations, %ld failures (%ld with enough free memory), "
+        "mean %.0f cycles, max %llu\n", s->allocs, s->failures, s->fragmented,
+        s->allocs + s->failures ? (double)s->alloc_cycles / (s->allocs + s->failures) : 0.0,
+        (unsigned long long)s->alloc_cycles_max);
+    printf("memFree: %ld frees, mean %.0f cycles, max %llu\n", s->frees,
+        s->frees ? (double)s->free_cycles / s->frees : 0.0, (unsigned long long)s->free_cycles_max);
+    printf("%ld splits, %ld merges\n", s->splits, s->merges);
+    if (s->failures)
+    {
+        printf("%8s %9s\n", "mem MB", "failures");
+        for (int order = 0; order < MAB_ORDERS; order++)
+            if (s->failures_by_order[order])
+                printf("%8d %9ld\n", BLOCK_MIN_SIZE << order, s->failures_by_order[order]);
+    }
+}
+
+#ifndef MAB_BITMAP
+/* Pointer tree backend ***************************************/
+
+/* The root block is embedded at the start of its heap, so any block can
+   find the per-order free lists by climbing to the root. */
+struct mab_heap {
+    Mab root;
+    MabPtr free_list[MAB_ORDERS]; // unallocated leaves, one list per block size
+    PoolPtr nodes; // child blocks, sized for a fully split tree
+    MabStats stats;
+    MabPtr changed[MAB_ORDERS]; // blocks the last memAlloc/memFree changed, for printMemChanges
+    int changed_count;
+};
+
+typedef struct mab_heap MabHeap;
+typedef MabHeap * MabHeapPtr;
+
+/*******************************************************
+ * static helpers - heap and free list maintenance
+ ******************************************************/
+
+static MabHeapPtr mab_heap(MabPtr m)
+{
+    while (m->parent)
+        m = m->parent;
+    return (MabHeapPtr)m;
+}
+
+static void free_list_push(MabHeapPtr h, MabPtr m)
+{
+    int order = mab_order(m->size);
+    m->prev_free = NULL;
+    m->next_free = h->free_list[order];
+    if (m->next_free)
+        m->next_free->prev_free = m;
+    h->free_list[order] = m;
+}
+
+static void free_list_remove(MabHeapPtr h, MabPtr m)
+{
+    if (m->prev_free)
+        m->prev_free->next_free = m->next_free;
+    else
+        h->free_list[mab_order(m->size)] = m->next_free;
+    if (m->next_free)
+        m->next_free->prev_free = m->prev_free;
+    m->prev_free = NULL;
+    m->next_free = NULL;
+}
+
+// give the unallocated leaf 'm' (already off its free list) two free halves
+static void split_block(MabHeapPtr h, MabPtr m)
+{
+    int halfSize = m->size / 2;
+
+    // Create left and right child blocks.
+    m->left_child = (MabPtr)poolAlloc(h->nodes);
+    m->right_child = (MabPtr)poolAlloc(h->nodes);
+
+    if (m->left_child == NULL || m->right_child == NULL)
+    {
+        fprintf(stderr, "FATAL: malloc() not working");
+        exit(EXIT_FAILURE);
+    }
+
+    m->left_child->policy = MEM_BUDDY;
+    m->right_child->policy = MEM_BUDDY;
+    m->left_child->offset = m->offset;
+    m->left_child->size = halfSize;
+    m->left_child->allocated = 0;
+    m->left_child->parent = m;
+    m->left_child->left_child = NULL;
+    m->left_child->right_child = NULL;
+
+    m->right_child->offset = m->offset + halfSize;
+    m->right_child->size = halfSize;
+    m->right_child->allocated = 0;
+    m->right_child->parent = m;
+    m->right_child->left_child = NULL;
+    m->right_child->right_child = NULL;
+
+    m->size = 0;
+    m->allocated = 2; // 2 means this block has children who are allocated
+    h->stats.splits++;
+}
+
+/*******************************************************
+ * MabPtr memInit(int offset, int size) - create the root
+ *    block of a buddy heap
+ *
+ * Parameters:
+ *   offset - starting address of the managed memory.
+ *   size - size of the managed memory, a power of two
+ *          between BLOCK_MIN_SIZE and MEM_LIMIT.
+ *
+ * Returns:
+ *   A pointer to the root block or NULL if malloc failed.
+ ******************************************************/
+MabPtr memInit(int offset, int size)
+{
+    MabHeapPtr h = (MabHeapPtr)calloc(1, sizeof(MabHeap));
+    if (h == NULL)
+    {
+        fprintf(stderr, "ERROR: Could not create memory heap\n");
+        return NULL;
+    }
+
+    // a fully split tree has 2 * (size / BLOCK_MIN_SIZE) - 1 blocks, one is the root
+    if (!(h->nodes = poolCreate(sizeof(Mab), 2 * (size / BLOCK_MIN_SIZE) - 2)))
+    {
+        free(h);
+        return NULL;
+    }
+
+    h->root.offset = offset;
+    h->root.size = size;
+    h->root.allocated = 0;
+    free_list_push(h, &h->root);
+    h->stats.free = size;
+    h->stats.largest_free = size;
+
+    return &h->root;
+}
+
+/*******************************************************
+ * void memClose(MabPtr m) - release the heap that block
+ *    'm' belongs to, every block of it becomes invalid
+ ******************************************************/
+void memClose(MabPtr m)
+{
+    if (m == NULL)
+        return;
+    if (m->policy != MEM_BUDDY)
+    {
+        fitClose(m);
+        return;
+    }
+    MabHeapPtr h = mab_heap(m);
+    poolDestroy(h->nodes);
+    free(h);
+}
 
 /*******************************************************
- * USER FUNCTION 
+ * PoolPtr memPool(MabPtr m) - node pool of the heap that
+ *    block 'm' belongs to, for its live/peak counters
+ ******************************************************/
+PoolPtr memPool(MabPtr m)
+{
+    if (m->policy != MEM_BUDDY)
+        return fitPool(m);
+    return mab_heap(m)->nodes;
+}
+
+/*******************************************************
+ * MabStatsPtr memStats(MabPtr m) - live counters of the
+ *    heap that block 'm' belongs to
+ *
+ * The counters are kept up to date by memAlloc, memFree,
+ * memSplit and memMerge; only largest_free is worked out
+ * here, from the highest non-empty free list.
+ ******************************************************/
+MabStatsPtr memStats(MabPtr m)
+{
+    if (m->policy != MEM_BUDDY)
+        return fitStats(m);
+
+    MabHeapPtr h = mab_heap(m);
+    int order = MAB_ORDERS - 1;
+
+    while (order >= 0 && !h->free_list[order])
+        order--;
+    h->stats.largest_free = order < 0 ? 0 : BLOCK_MIN_SIZE << order;
+    return &h->stats;
+}
+
+/*******************************************************
+ * USER FUNCTION
  * void print_mem_info - prints current state of virtual memory
  *
  * use for testing
  ******************************************************/
 void print_mem_info(MabPtr m) {
-    if (m == NULL) 
+    if (m == NULL)
         return;  // Stop the traversal if the current node is NULL.
+    if (m->policy != MEM_BUDDY)
+    {
+        fitPrint(m);
+        return;
+    }
 
     if (m->size)
-        printf("Offset: %d, Size: %d, Allocated: %d\n", m->offset, m->size, m->allocated);
+        logPrintf("Offset: %d, Size: %d, Allocated: %d\n", m->offset, m->size, m->allocated);
 
     // Recursively traverse the left and right children.
     print_mem_info(m->left_child);
     print_mem_info(m->right_child);
 }
 
+/*******************************************************
+ * void printMemChanges(MabPtr m) - print the leaf blocks
+ *    the last memAlloc or memFree on the heap of 'm'
+ *    created or changed, by offset, in print_mem_info's
+ *    format
+ *
+ * After memAlloc that is the allocated block and the free
+ * halves split off on the way down to it, after memFree
+ * the free block left once the buddies were merged; blocks
+ * merged away are covered by it.
+ ******************************************************/
+void printMemChanges(MabPtr m)
+{
+    if (m->policy != MEM_BUDDY)
+    {
+        fitChanges(m);
+        return;
+    }
+
+    MabHeapPtr h = mab_heap(m);
+
+    // split halves are recorded largest (highest offset) first
+    for (int i = h->changed_count - 1; i >= 0; i--)
+    {
+        MabPtr c = h->changed[i];
+        logPrintf("Offset: %d, Size: %d, Allocated: %d\n", c->offset, c->size, c->allocated);
+    }
+}
+
 /*******************************************************
  * MabPtr memMerge(MabPtr m) - Merge buddy memory blocks.
  *
  * Returns: A pointer to the merged memory block
  ******************************************************/
 MabPtr memMerge(MabPtr m) {
-    if (m == NULL) 
+    if (m == NULL)
         return NULL;  // Base case: If the node is NULL, return NULL.
+    if (m->policy != MEM_BUDDY)
+        return m; // fit heaps coalesce as they free
 
     // Recursive call to merge left and right children.
-    MabPtr mergedLeft = memMerge(m->left_child);
-    MabPtr mergedRight = memMerge(m->right_child);
+    memMerge(m->left_child);
+    memMerge(m->right_child);
 
     // Check if both children are NULL (leaf nodes) and unallocated.
     if (m->left_child != NULL && m->right_child != NULL &&
         !m->left_child->allocated && !m->right_child->allocated) {
         // Merge the current block with its buddy.
+        MabHeapPtr h = mab_heap(m);
+        free_list_remove(h, m->left_child);
+        free_list_remove(h, m->right_child);
+
         m->allocated = 0;
         m->size = 2 * m->left_child->size;
+        poolFree(h->nodes, m->left_child);
+        poolFree(h->nodes, m->right_child);
         m->left_child = NULL;
         m->right_child = NULL;
+        free_list_push(h, m);
+        h->stats.merges++;
     }
 
-    // Return the merged block 
+    // Return the merged block
     return m;
 }
 
@@ -52,75 +397,35 @@ MabPtr memMerge(MabPtr m) {
  * MabPtr memSplit(MabPtr m, int size) - Split a memory block
  *
  * Parameters:
- *   m - The memory block to be split.
+ *   m - The unallocated leaf block to be split.
  *   size - The size of memory to be allocated.
  *
+ * The right half of every split is put on its free list,
+ * the left half is split further until it just fits 'size'.
+ *
  * Returns:
  *   A pointer to the newly split memory block or NULL if it cannot be split.
  ******************************************************/
 MabPtr memSplit(MabPtr m, int size) {
-    if (m == NULL || m->allocated || m->size < size) 
+    if (m == NULL || m->policy != MEM_BUDDY || m->allocated || m->left_child || m->size < size)
         return NULL; // This block is not suitable for splitting.
 
-    // Recursevily split blocks until allocation can be facilitiated
-    if (m->size >= 2 * size && 
-    (m->left_child == NULL && m->right_child == NULL)) 
-    {
-        int halfSize = m->size / 2;
-
-        // Create left and right child blocks.
-        m->left_child = (MabPtr)malloc(sizeof(Mab));
-        m->right_child = (MabPtr)malloc(sizeof(Mab));
-
-        if (m->left_child == NULL || m->right_child == NULL) 
-        {
-            // Memory allocation for left or right child failed.
-            if (m->left_child) 
-            {
-                free(m->left_child);
-                m->left_child = NULL;
-            }
-            if (m->right_child) 
-            {
-                free(m->right_child);
-                m->right_child = NULL;
-            }
-            fprintf(stderr, "FATAL: malloc() not working");
-            exit(EXIT_FAILURE);
-        }
-
-        m->left_child->offset = m->offset;
-        m->left_child->size = halfSize;
-        m->left_child->allocated = 0;
-        m->left_child->parent = m;
-        m->left_child->left_child = NULL;
-        m->left_child->right_child = NULL;
+    MabHeapPtr h = mab_heap(m);
+    free_list_remove(h, m);
 
-        m->right_child->offset = m->offset + halfSize;
-        m->right_child->size = halfSize;
-        m->right_child->allocated = 0;
-        m->right_child->parent = m;
-        m->right_child->left_child = NULL;
-        m->right_child->right_child = NULL;
-
-        m->size = 0;
-        m->allocated = 2; // 2 means this block has children who are allocated
+    // Split blocks until allocation can be facilitated
+    while (m->size >= 2 * size && m->size > BLOCK_MIN_SIZE)
+    {
+        split_block(h, m);
+        free_list_push(h, m->right_child);
+        if (h->changed_count < MAB_ORDERS - 1)
+            h->changed[h->changed_count++] = m->right_child;
 
         // Continue the allocation attempt in the left child
-        MabPtr block_to_allocate = memSplit(m->left_child, size);
-        if (block_to_allocate) 
-            return block_to_allocate;
-
-        // If the left child failed, try the right child.
-        return memSplit(m->right_child, size);
+        m = m->left_child;
     }
 
-    // Check if the current block can be allocated
-    if ((m->size >= size && size > (m->size / 2)) 
-        || (m->size == 8 && size < 8))
-        return m;
-
-    return NULL; // Unable to split this block.
+    return m;
 }
 
 
@@ -131,69 +436,233 @@ MabPtr memSplit(MabPtr m, int size) {
  *   m - The root block/node of the binary tree.
  *   size - The size of memory to be allocated.
  *
+ * Takes the first block from the smallest non-empty free list
+ * that can hold 'size', splitting it down if it is too big.
+ *
  * Returns:
  *   A pointer to the allocated memory block or NULL if no suitable block is found.
  ******************************************************/
 MabPtr memAlloc(MabPtr m, int size) {
-    if (m == NULL || size < 1 || size > 2048) 
+    if (m == NULL || size < 1 || size > MEM_LIMIT)
         return NULL;  // No suitable block found.
+    if (m->policy != MEM_BUDDY)
+        return fitAlloc(m, size);
 
-    // Check if the current block can be allocated without having to split blocks
-    if (!m->allocated) 
+    uint64_t start = memCycles();
+    MabHeapPtr h = mab_heap(m);
+    MabPtr allocated_block = NULL;
+    h->changed_count = 0;
+    for (int order = mab_order(size); order < MAB_ORDERS; order++)
     {
-        if ((m->size >= size && size > (m->size / 2)) 
-            || (m->size == 8 && size < 8)) 
+        if (h->free_list[order])
         {
-                m->allocated = 1;
-                return m;
+            allocated_block = memSplit(h->free_list[order], size);
+            allocated_block->allocated = 1;
+            allocated_block->request = size;
+            h->changed[h->changed_count++] = allocated_block;
+            break;
         }
     }
 
-    // Try left_child first, then try right_child
-    if (m->left_child)
+    MabStatsPtr s = &h->stats;
+    if (allocated_block)
     {
-        MabPtr left_result = memAlloc(m->left_child, size);
-        if (left_result) {
-            return left_result;
-        } else {
-            MabPtr right_result = memAlloc(m->right_child, size);
-            if (right_result)
-                return right_result;
-        }
+        s->allocs++;
+        s->allocated += allocated_block->size;
+        s->requested += size;
+        s->free -= allocated_block->size;
+        if (s->allocated > s->peak_allocated)
+            s->peak_allocated = s->allocated;
     }
+    else
+    {
+        // No suitable block found in the entire tree.
+        s->failures++;
+        s->failures_by_order[mab_order(size)]++;
+        if (s->free >= BLOCK_MIN_SIZE << mab_order(size)) // enough memory, but not in one block
+            s->fragmented++;
+    }
+    uint64_t cycles = memCycles() - start;
+    s->alloc_cycles += cycles;
+    if (cycles > s->alloc_cycles_max)
+        s->alloc_cycles_max = cycles;
 
+    return allocated_block;
+}
 
-    /* If no suitable unallocated block is found during traversal, 
-        split until a suitable block is found */
-    MabPtr allocated_block = memSplit(m, size);
-    if (allocated_block) {
-        allocated_block->allocated = 1;
-        return allocated_block;
+/*******************************************************
+ * MabPtr memAllocAt(MabPtr m, int offset, int size) -
+ *    allocate the block for 'size' that starts at 'offset',
+ *    as memAlloc once gave it out (see checkpoint.c)
+ *
+ * Parameters:
+ *   m - The root block/node of the binary tree.
+ *   offset - Where the block starts, aligned to its size.
+ *   size - The size of memory that was asked for.
+ *
+ * Descends to the free leaf holding 'offset' and splits it
+ * towards 'offset', putting the other halves on their free
+ * lists. The stats count it as one allocation.
+ *
+ * Returns:
+ *   The allocated block or NULL if that memory is not free.
+ ******************************************************/
+MabPtr memAllocAt(MabPtr m, int offset, int size) {
+    if (m == NULL || size < 1 || size > MEM_LIMIT)
+        return NULL;
+    if (m->policy != MEM_BUDDY)
+        return fitAllocAt(m, offset, size);
+
+    MabHeapPtr h = mab_heap(m);
+    int block_size = BLOCK_MIN_SIZE << mab_order(size);
+    MabPtr b = &h->root;
+
+    if (offset < b->offset || (offset - b->offset) % block_size)
+        return NULL;
+    while (b->left_child)
+        b = offset < b->right_child->offset ? b->left_child : b->right_child;
+    if (b->allocated || b->size < block_size || offset + block_size > b->offset + b->size)
+        return NULL;
+
+    free_list_remove(h, b);
+    while (b->size > block_size)
+    {
+        split_block(h, b);
+        if (offset < b->right_child->offset)
+        {
+            free_list_push(h, b->right_child);
+            b = b->left_child;
+        }
+        else
+        {
+            free_list_push(h, b->left_child);
+            b = b->right_child;
+        }
     }
+    b->allocated = 1;
+    b->request = size;
+    h->changed[0] = b;
+    h->changed_count = 1;
 
-    return NULL; // No suitable block found in the entire tree.
+    MabStatsPtr s = &h->stats;
+    s->allocs++;
+    s->allocated += b->size;
+    s->requested += size;
+    s->free -= b->size;
+    if (s->allocated > s->peak_allocated)
+        s->peak_allocated = s->allocated;
+    return b;
+}
+
+/*******************************************************
+ * int memFreeOrder(MabPtr m, int * offsets, int max) -
+ *    list the free blocks of the heap of 'm' in the order
+ *    memAlloc tries them: by order, each free list from its
+ *    head. Offsets are from the start of the heap.
+ *
+ * Which block of an order memAlloc takes depends on the
+ * order blocks were freed in, which memAllocAt cannot
+ * recreate; memSetFreeOrder puts it back.
+ *
+ * Returns:
+ *   The number of free blocks, at most 'max' are listed.
+ ******************************************************/
+int memFreeOrder(MabPtr m, int * offsets, int max) {
+    if (m->policy != MEM_BUDDY)
+        return fitFreeOrder(m, offsets, max);
+
+    MabHeapPtr h = mab_heap(m);
+    int count = 0;
+
+    for (int order = 0; order < MAB_ORDERS; order++)
+        for (MabPtr b = h->free_list[order]; b; b = b->next_free, count++)
+            if (count < max)
+                offsets[count] = b->offset - h->root.offset;
+    return count;
+}
+
+/*******************************************************
+ * int memSetFreeOrder(MabPtr m, const int * offsets,
+ *    int count) - reorder the free lists of the heap of 'm'
+ *    as memFreeOrder listed them
+ *
+ * Returns:
+ *   TRUE, or FALSE if an offset is not that of a free block.
+ ******************************************************/
+int memSetFreeOrder(MabPtr m, const int * offsets, int count) {
+    if (m->policy != MEM_BUDDY)
+        return fitSetFreeOrder(m, offsets, count);
+
+    MabHeapPtr h = mab_heap(m);
+
+    // moving each block to the head of its list, last first, leaves them in list order
+    for (int i = count - 1; i >= 0; i--)
+    {
+        int offset = h->root.offset + offsets[i];
+        MabPtr b = &h->root;
+        while (b->left_child)
+            b = offset < b->right_child->offset ? b->left_child : b->right_child;
+        if (b->allocated || b->offset != offset)
+            return FALSE;
+        free_list_remove(h, b);
+        free_list_push(h, b);
+    }
+    return TRUE;
 }
 
 /*******************************************************
  * MabPtr memFree(MabPtr m) - Free memory block.
  *
+ * Coalesces the freed block with its buddy, then the parent
+ * with its buddy and so on, stopping at the first ancestor
+ * whose buddy is still (partly) allocated.
+ *
  * returns: A pointer to the freed memory block.
  ******************************************************/
 MabPtr memFree(MabPtr m) {
-    if (m == NULL || !m->allocated) 
+    if (m == NULL || m->allocated != 1)
         return NULL;  // Cannot free an already unallocated block or NULL.
+    if (m->policy != MEM_BUDDY)
+        return fitFree(m);
 
     // Mark the provided block as unallocated.
+    uint64_t start = memCycles();
+    MabHeapPtr h = mab_heap(m);
+    MabStatsPtr s = &h->stats;
     m->allocated = 0;
+    s->frees++;
+    s->allocated -= m->size;
+    s->requested -= m->request;
+    s->free += m->size;
 
-    // Perform block merging (start from root).
-    MabPtr root = m;
-    while (root->parent)
-        root = root->parent;
-    memMerge(root);
+    // Merge with the buddy while it is an unallocated leaf.
+    while (m->parent)
+    {
+        MabPtr parent = m->parent;
+        MabPtr buddy = parent->left_child == m ? parent->right_child : parent->left_child;
+        if (buddy->allocated)
+            break;
+
+        free_list_remove(h, buddy);
+        parent->allocated = 0;
+        parent->size = 2 * m->size;
+        parent->left_child = NULL;
+        parent->right_child = NULL;
+        poolFree(h->nodes, buddy);
+        poolFree(h->nodes, m);
+        m = parent;
+        s->merges++;
+    }
+    free_list_push(h, m);
+    h->changed[0] = m;
+    h->changed_count = 1;
 
-    printf("\n");
-    print_mem_info(root);
+    uint64_t cycles = memCycles() - start;
+    s->free_cycles += cycles;
+    if (cycles > s->free_cycles_max)
+        s->free_cycles_max = cycles;
 
-    return NULL;
+    return m;
 }
+
+#endif /* MAB_BITMAP */
@@ -10,6 +10,9 @@
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <stdint.h>
+#include "pool.h"
+#include "logger.h"
 
 #ifndef FALSE
 #define FALSE 0
@@ -20,7 +23,17 @@
 #endif
 
 // megabytes
-#define BLOCK_MIN_SIZE = 8
+#define MEM_LIMIT 2048
+#define BLOCK_MIN_SIZE 8
+#define MAB_ORDERS 9 // block sizes 8, 16, ... 2048 (BLOCK_MIN_SIZE << order)
+
+/* Allocation policies */
+#define MEM_BUDDY 0 // power-of-two buddy blocks (pointer tree, or bitmaps with MAB_BITMAP)
+#define MEM_SEGREGATED 1 // exact-size blocks, free lists by size class
+#define MEM_FIRST_FIT 2 // exact-size blocks, lowest free block that fits
+#define MEM_BEST_FIT 3 // exact-size blocks, smallest free block that fits
+#define MEM_POLICIES 4
+#define FIT_CLASSES 12 // segregated fit size classes: 1, 2-3, 4-7, ... 2048 MB
 
 /* Custom Data Types */
 struct mab {
@@ -30,16 +43,67 @@ struct mab {
     struct mab * parent; // for use in the Buddy binary tree
     struct mab * left_child; // for use in the binary tree
     struct mab * right_child; // for use in the binary tree
+    struct mab * prev_free; // free list links, only valid while the block
+    struct mab * next_free; //   is an unallocated leaf
+    int request; // size asked for, while the block is allocated
+    int policy; // MEM_* policy of the heap the block belongs to
 };
 
 typedef struct mab Mab;
 typedef Mab * MabPtr;
 
+/* Live counters of one buddy heap, in megabytes unless noted */
+struct mab_stats {
+    long allocated; // in allocated blocks
+    long requested; // asked for by the allocated blocks; the rest is internal fragmentation
+    long free; // in free blocks
+    long largest_free; // largest free block, refreshed by memStats
+    long peak_allocated;
+    long allocs, frees; // successful memAlloc / memFree calls
+    long failures; // memAlloc calls that found no block
+    long fragmented; // ... of which the heap had enough free memory in total for the
+                     // block needed (buddy: the power of two the size rounds up to)
+    long failures_by_order[MAB_ORDERS]; // failures by the requested size class (see memOrder)
+    long splits, merges;
+    uint64_t alloc_cycles, free_cycles; // total time spent in memAlloc / memFree, in cycles
+    uint64_t alloc_cycles_max, free_cycles_max;
+};
+
+typedef struct mab_stats MabStats;
+typedef MabStats * MabStatsPtr;
+
 /* Function Prototypes */
+MabPtr memInit(int offset, int size); // create the root block and its free lists
+MabPtr memInitPolicy(int policy, int offset, int size); // memInit for any MEM_* policy
+int parseMemPolicy(int * policy, const char * name); // "buddy", "segregated", "first-fit", "best-fit"
+const char * memPolicyName(int policy);
+void memClose(MabPtr m); // release the heap 'm' belongs to and all its blocks
+PoolPtr memPool(MabPtr m); // node pool of the heap 'm' belongs to, NULL if it has none
+int memOrder(int size); // order (size class) of the block that would hold 'size'
+uint64_t memCycles(void); // time stamp counter used for the latency counters
+MabStatsPtr memStats(MabPtr m); // live counters of the heap 'm' belongs to
+void printMemStats(MabPtr m); // allocator counters and fragmentation on stdout
 void print_mem_info(MabPtr m); // prints current state of virtual memory
+void printMemChanges(MabPtr m); // prints the blocks the last memAlloc/memFree changed
 MabPtr memMerge(MabPtr m); // merge buddy memory blocks 
 MabPtr memSplit(MabPtr m, int size); // split a memory block
 MabPtr memAlloc(MabPtr m, int size); // allocate memory block 
+MabPtr memAllocAt(MabPtr m, int offset, int size); // allocate the block at 'offset', to rebuild a heap
+int memFreeOrder(MabPtr m, int * offsets, int max); // offsets of the free blocks in the order memAlloc tries them
+int memSetFreeOrder(MabPtr m, const int * offsets, int count); // put the free blocks back in that order
 MabPtr memFree(MabPtr m); // free memory block
 
+/* Fit heaps (mab_fit.c), reached through the functions above */
+MabPtr fitInit(int policy, int offset, int size);
+void fitClose(MabPtr m);
+PoolPtr fitPool(MabPtr m);
+MabStatsPtr fitStats(MabPtr m);
+void fitPrint(MabPtr m);
+void fitChanges(MabPtr m);
+MabPtr fitAlloc(MabPtr m, int size);
+MabPtr fitAllocAt(MabPtr m, int offset, int size);
+int fitFreeOrder(MabPtr m, int * offsets, int max);
+int fitSetFreeOrder(MabPtr m, const int * offsets, int count);
+MabPtr fitFree(MabPtr m);
+
 #endif
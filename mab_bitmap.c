@@ -0,0 +1,484 @@
+/* Flat bitmap buddy heap for MLQD dispatcher (make MAB=bitmap)
+
+   The whole buddy tree is one array of Mab nodes in heap order - the
+   children of node n are 2n + 1 and 2n + 2 - allocated by memInit for
+   the size of the pool, with every offset and size filled in up front.
+   Which blocks are free is kept in one bitmap per order: memAlloc finds
+   the lowest free block of the smallest order that fits by scanning
+   words with ctz, memFree merges by testing the buddy's bit. Nodes are
+   never linked; the parent of every node is the root, so any block
+   finds its heap in one step.
+*/
+
+/* Include Files */
+#include <stddef.h>
+#include "mab.h"
+
+#ifdef MAB_BITMAP
+
+struct mab_heap {
+    int root_order; // order of node[0]
+    uint64_t * free_map[MAB_ORDERS]; // bit i set: block i of that order is a free leaf
+    MabStats stats;
+    MabPtr changed[MAB_ORDERS]; // blocks the last memAlloc/memFree changed, for printMemChanges
+    int changed_count;
+    Mab node[]; // 2^(root_order + 1) - 1 nodes, node[0] is the root
+};
+
+typedef struct mab_heap MabHeap;
+typedef MabHeap * MabHeapPtr;
+
+/*******************************************************
+ * static helpers - node indexing and bitmaps
+ ******************************************************/
+
+// order of the smallest block that can hold 'size' megabytes
+static inline int block_order(int size)
+{
+    return size <= BLOCK_MIN_SIZE ? 0 : 32 - __builtin_clz((unsigned)(size - 1) / BLOCK_MIN_SIZE);
+}
+
+static inline MabHeapPtr mab_heap(MabPtr m)
+{
+    return (MabHeapPtr)((char *)(m->parent ? m->parent : m) - offsetof(MabHeap, node));
+}
+
+// node of block 'i' of 'order'
+static inline int node_index(MabHeapPtr h, int order, int i)
+{
+    return (1 << (h->root_order - order)) - 1 + i;
+}
+
+static inline int node_order(MabHeapPtr h, int n)
+{
+    return h->root_order - (31 - __builtin_clz((unsigned)n + 1));
+}
+
+// position of node 'n' among the blocks of its order
+static inline int node_block(int n)
+{
+    return n + 1 - (1 << (31 - __builtin_clz((unsigned)n + 1)));
+}
+
+static inline int is_free(MabHeapPtr h, int order, int i)
+{
+    return (h->free_map[order][i >> 6] >> (i & 63)) & 1;
+}
+
+static inline void set_free(MabHeapPtr h, int order, int i)
+{
+    h->free_map[order][i >> 6] |= 1ULL << (i & 63);
+}
+
+static inline void clear_free(MabHeapPtr h, int order, int i)
+{
+    h->free_map[order][i >> 6] &= ~(1ULL << (i & 63));
+}
+
+// lowest free block of 'order', -1 if there is none
+static int find_free(MabHeapPtr h, int order)
+{
+    int words = ((1 << (h->root_order - order)) + 63) >> 6;
+    for (int w = 0; w < words; w++)
+        if (h->free_map[order][w])
+            return (w << 6) + __builtin_ctzll(h->free_map[order][w]);
+    return -1;
+}
+
+// split free block 'i' of 'order' (already off its bitmap) down to 'want',
+// freeing the right half at every step; returns the left-most piece
+static MabPtr split_down(MabHeapPtr h, int order, int i, int want)
+{
+    while (order > want)
+    {
+        order--;
+        i <<= 1;
+        set_free(h, order, i + 1);
+        if (h->changed_count < MAB_ORDERS - 1)
+            h->changed[h->changed_count++] = &h->node[node_index(h, order, i + 1)];
+        h->stats.splits++;
+    }
+    return &h->node[node_index(h, order, i)];
+}
+
+/*******************************************************
+ * MabPtr memInit(int offset, int size) - create the root
+ *    block of a buddy heap
+ *
+ * Parameters:
+ *   offset - starting address of the managed memory.
+ *   size - size of the managed memory, a power of two
+ *          between BLOCK_MIN_SIZE and MEM_LIMIT.
+ *
+ * Returns:
+ *   A pointer to the root block or NULL if malloc failed.
+ ******************************************************/
+MabPtr memInit(int offset, int size)
+{
+    int root_order = block_order(size);
+    int nodes = (2 << root_order) - 1;
+    int words = 0;
+
+    for (int order = 0; order <= root_order; order++)
+        words += ((1 << (root_order - order)) + 63) >> 6;
+
+    MabHeapPtr h = (MabHeapPtr)calloc(1, sizeof(MabHeap) + nodes * sizeof(Mab));
+    uint64_t * maps = (uint64_t *)calloc(words, sizeof(uint64_t));
+    if (h == NULL || maps == NULL)
+    {
+        fprintf(stderr, "ERROR: Could not create memory heap\n");
+        free(h);
+        free(maps);
+        return NULL;
+    }
+
+    h->root_order = root_order;
+    for (int order = root_order; order >= 0; order--)
+    {
+        h->free_map[order] = maps;
+        maps += ((1 << (root_order - order)) + 63) >> 6;
+    }
+    for (int n = 0; n < nodes; n++)
+    {
+        Mab * m = &h->node[n];
+        m->size = BLOCK_MIN_SIZE << node_order(h, n);
+        m->offset = offset + node_block(n) * m->size;
+        m->parent = n ? &h->node[0] : NULL;
+    }
+    set_free(h, root_order, 0);
+    h->stats.free = size;
+    h->stats.largest_free = size;
+
+    return &h->node[0];
+}
+
+/*******************************************************
+ * void memClose(MabPtr m) - release the heap that block
+ *    'm' belongs to, every block of it becomes invalid
+ ******************************************************/
+void memClose(MabPtr m)
+{
+    if (m == NULL)
+        return;
+    if (m->policy != MEM_BUDDY)
+    {
+        fitClose(m);
+        return;
+    }
+    MabHeapPtr h = mab_heap(m);
+    free(h->free_map[h->root_order]); // the maps are one allocation, root order first
+    free(h);
+}
+
+/*******************************************************
+ * PoolPtr memPool(MabPtr m) - the nodes are one array,
+ *    there is no pool (fit heaps have one)
+ ******************************************************/
+PoolPtr memPool(MabPtr m)
+{
+    if (m->policy != MEM_BUDDY)
+        return fitPool(m);
+    return NULL;
+}
+
+/*******************************************************
+ * MabStatsPtr memStats(MabPtr m) - live counters of the
+ *    heap that block 'm' belongs to
+ *
+ * The counters are kept up to date by memAlloc and
+ * memFree; only largest_free is worked out here, from the
+ * highest order with a free bit.
+ ******************************************************/
+MabStatsPtr memStats(MabPtr m)
+{
+    if (m->policy != MEM_BUDDY)
+        return fitStats(m);
+
+    MabHeapPtr h = mab_heap(m);
+    int order = h->root_order;
+
+    while (order >= 0 && find_free(h, order) < 0)
+        order--;
+    h->stats.largest_free = order < 0 ? 0 : BLOCK_MIN_SIZE << order;
+    return &h->stats;
+}
+
+/*******************************************************
+ * USER FUNCTION
+ * void print_mem_info - prints current state of virtual memory
+ *
+ * Same output as the pointer tree: every allocated or free
+ * block under 'm', by offset.
+ ******************************************************/
+void print_mem_info(MabPtr m) {
+    if (m == NULL)
+        return;
+    if (m->policy != MEM_BUDDY)
+    {
+        fitPrint(m);
+        return;
+    }
+
+    MabHeapPtr h = mab_heap(m);
+    int n = m - h->node;
+    int order = node_order(h, n);
+
+    if (m->allocated || is_free(h, order, node_block(n)))
+        logPrintf("Offset: %d, Size: %d, Allocated: %d\n", m->offset, m->size, m->allocated);
+    else if (order > 0) // split: print the halves
+    {
+        print_mem_info(&h->node[2 * n + 1]);
+        print_mem_info(&h->node[2 * n + 2]);
+    }
+}
+
+/*******************************************************
+ * void printMemChanges(MabPtr m) - print the blocks the
+ *    last memAlloc or memFree on the heap of 'm' created
+ *    or changed, by offset (see mab.c)
+ ******************************************************/
+void printMemChanges(MabPtr m)
+{
+    if (m->policy != MEM_BUDDY)
+    {
+        fitChanges(m);
+        return;
+    }
+
+    MabHeapPtr h = mab_heap(m);
+
+    // split halves are recorded largest (highest offset) first
+    for (int i = h->changed_count - 1; i >= 0; i--)
+    {
+        MabPtr c = h->changed[i];
+        logPrintf("Offset: %d, Size: %d, Allocated: %d\n", c->offset, c->size, c->allocated);
+    }
+}
+
+/*******************************************************
+ * MabPtr memMerge(MabPtr m) - memFree merges buddies as
+ *    soon as both are free (fit heaps coalesce the same
+ *    way), so there is never anything left to merge
+ *
+ * Returns: m
+ ******************************************************/
+MabPtr memMerge(MabPtr m) {
+    return m;
+}
+
+/*******************************************************
+ * MabPtr memSplit(MabPtr m, int size) - Split a memory block
+ *
+ * Parameters:
+ *   m - The free block to be split.
+ *   size - The size of memory to be allocated.
+ *
+ * Returns:
+ *   The left-most block that just fits 'size', still free
+ *   but off its bitmap, or NULL if 'm' cannot be split.
+ ******************************************************/
+MabPtr memSplit(MabPtr m, int size) {
+    if (m == NULL || m->policy != MEM_BUDDY || m->allocated || m->size < size)
+        return NULL;
+
+    MabHeapPtr h = mab_heap(m);
+    int n = m - h->node;
+    int order = node_order(h, n);
+    if (!is_free(h, order, node_block(n)))
+        return NULL; // split already, or inside an allocated block
+
+    clear_free(h, order, node_block(n));
+    return split_down(h, order, node_block(n), block_order(size));
+}
+
+/*******************************************************
+ * MabPtr memAlloc(MabPtr m, int size) - Allocate a memory block.
+ *
+ * Parameters:
+ *   m - The root block of the heap.
+ *   size - The size of memory to be allocated.
+ *
+ * Takes the lowest free block of the smallest order that
+ * can hold 'size', splitting it down if it is too big.
+ *
+ * Returns:
+ *   A pointer to the allocated memory block or NULL if no suitable block is found.
+ ******************************************************/
+MabPtr memAlloc(MabPtr m, int size) {
+    if (m == NULL || size < 1 || size > MEM_LIMIT)
+        return NULL;
+    if (m->policy != MEM_BUDDY)
+        return fitAlloc(m, size);
+
+    uint64_t start = memCycles();
+    MabHeapPtr h = mab_heap(m);
+    MabPtr allocated_block = NULL;
+    int want = block_order(size);
+    h->changed_count = 0;
+    for (int order = want; order <= h->root_order; order++)
+    {
+        int i = find_free(h, order);
+        if (i >= 0)
+        {
+            clear_free(h, order, i);
+            allocated_block = split_down(h, order, i, want);
+            allocated_block->allocated = 1;
+            allocated_block->request = size;
+            h->changed[h->changed_count++] = allocated_block;
+            break;
+        }
+    }
+
+    MabStatsPtr s = &h->stats;
+    if (allocated_block)
+    {
+        s->allocs++;
+        s->allocated += allocated_block->size;
+        s->requested += size;
+        s->free -= allocated_block->size;
+        if (s->allocated > s->peak_allocated)
+            s->peak_allocated = s->allocated;
+    }
+    else
+    {
+        s->failures++;
+        s->failures_by_order[want < MAB_ORDERS ? want : MAB_ORDERS - 1]++;
+        if (want < MAB_ORDERS && s->free >= BLOCK_MIN_SIZE << want) // enough memory, but not in one block
+            s->fragmented++;
+    }
+    uint64_t cycles = memCycles() - start;
+    s->alloc_cycles += cycles;
+    if (cycles > s->alloc_cycles_max)
+        s->alloc_cycles_max = cycles;
+
+    return allocated_block;
+}
+
+/*******************************************************
+ * MabPtr memAllocAt(MabPtr m, int offset, int size) -
+ *    allocate the block for 'size' that starts at 'offset'
+ *    (see mab.c)
+ *
+ * Finds the free block holding it by testing the bits of
+ * its ancestors, then splits that block towards it.
+ *
+ * Returns:
+ *   The allocated block or NULL if that memory is not free.
+ ******************************************************/
+MabPtr memAllocAt(MabPtr m, int offset, int size) {
+    if (m == NULL || size < 1 || size > MEM_LIMIT)
+        return NULL;
+    if (m->policy != MEM_BUDDY)
+        return fitAllocAt(m, offset, size);
+
+    MabHeapPtr h = mab_heap(m);
+    int want = block_order(size);
+    int block_size = BLOCK_MIN_SIZE << want;
+    int from = offset - h->node[0].offset;
+    int order = want;
+
+    if (want > h->root_order || from < 0 || from % block_size || from >= h->node[0].size)
+        return NULL;
+    int i = from / block_size;
+    while (order <= h->root_order && !is_free(h, order, i >> (order - want)))
+        order++;
+    if (order > h->root_order)
+        return NULL;
+
+    clear_free(h, order, i >> (order - want));
+    while (order > want)
+    {
+        order--;
+        set_free(h, order, (i >> (order - want)) ^ 1);
+        h->stats.splits++;
+    }
+    MabPtr b = &h->node[node_index(h, want, i)];
+    b->allocated = 1;
+    b->request = size;
+    h->changed[0] = b;
+    h->changed_count = 1;
+
+    MabStatsPtr s = &h->stats;
+    s->allocs++;
+    s->allocated += b->size;
+    s->requested += size;
+    s->free -= b->size;
+    if (s->allocated > s->peak_allocated)
+        s->peak_allocated = s->allocated;
+    return b;
+}
+
+/*******************************************************
+ * int memFreeOrder(MabPtr m, int * offsets, int max) -
+ *    memAlloc takes the lowest free block, whatever order
+ *    blocks were freed in: there is nothing to list
+ *
+ * Returns: 0 (fit heaps list theirs, see mab.c)
+ ******************************************************/
+int memFreeOrder(MabPtr m, int * offsets, int max) {
+    if (m->policy != MEM_BUDDY)
+        return fitFreeOrder(m, offsets, max);
+    return 0;
+}
+
+/*******************************************************
+ * int memSetFreeOrder(MabPtr m, const int * offsets,
+ *    int count) - nothing to reorder (see memFreeOrder);
+ *    the order a pointer tree heap listed is ignored
+ *
+ * Returns: TRUE unless a fit heap's offsets do not match
+ ******************************************************/
+int memSetFreeOrder(MabPtr m, const int * offsets, int count) {
+    if (m->policy != MEM_BUDDY)
+        return fitSetFreeOrder(m, offsets, count);
+    return TRUE;
+}
+
+/*******************************************************
+ * MabPtr memFree(MabPtr m) - Free memory block.
+ *
+ * Merges the freed block with its buddy while the buddy's
+ * free bit is set, then marks the merged block free.
+ *
+ * returns: A pointer to the merged free block.
+ ******************************************************/
+MabPtr memFree(MabPtr m) {
+    if (m == NULL || m->allocated != 1)
+        return NULL;
+    if (m->policy != MEM_BUDDY)
+        return fitFree(m);
+
+    uint64_t start = memCycles();
+    MabHeapPtr h = mab_heap(m);
+    MabStatsPtr s = &h->stats;
+    int n = m - h->node;
+    int order = node_order(h, n);
+    int i = node_block(n);
+
+    m->allocated = 0;
+    s->frees++;
+    s->allocated -= m->size;
+    s->requested -= m->request;
+    s->free += m->size;
+
+    while (order < h->root_order && is_free(h, order, i ^ 1))
+    {
+        clear_free(h, order, i ^ 1);
+        i >>= 1;
+        order++;
+        s->merges++;
+    }
+    set_free(h, order, i);
+    m = &h->node[node_index(h, order, i)];
+    h->changed[0] = m;
+    h->changed_count = 1;
+
+    uint64_t cycles = memCycles() - start;
+    s->free_cycles += cycles;
+    if (cycles > s->free_cycles_max)
+        s->free_cycles_max = cycles;
+
+    return m;
+}
+
+#endif /* MAB_BITMAP */
@@ -0,0 +1,439 @@
+/* Fit heaps for MLQD dispatcher: segregated, first and best fit
+
+   Unlike the buddy heap, blocks are exactly the size asked for, so
+   nothing is lost to power-of-two rounding. Every block, free or
+   allocated, is on an address-ordered list through left_child (the
+   block just below) and right_child (the block just above), so a freed
+   block coalesces with free neighbours in constant time. First and
+   best fit walk that list. Segregated fit also keeps the free blocks on
+   one list per size class (prev_free/next_free) and takes the first
+   block of the request's class that fits, else the head of the next
+   non-empty larger class.
+
+   The root heads the heap and is not a block itself; the parent of
+   every block is the root.
+*/
+
+/* Include Files */
+#include "mab.h"
+
+struct fit_heap {
+    Mab root; // offset and size of the whole pool
+    PoolPtr nodes; // blocks
+    MabPtr first; // lowest block
+    MabPtr free_list[FIT_CLASSES]; // MEM_SEGREGATED: free blocks by size class
+    MabStats stats;
+    MabPtr changed[2]; // blocks the last fitAlloc/fitFree changed, for fitChanges
+    int changed_count;
+};
+
+typedef struct fit_heap FitHeap;
+typedef FitHeap * FitHeapPtr;
+
+/*******************************************************
+ * static helpers - block lists
+ ******************************************************/
+
+static FitHeapPtr fit_heap(MabPtr m)
+{
+    return (FitHeapPtr)(m->parent ? m->parent : m);
+}
+
+// size class: floor(log2(size))
+static int fit_class(int size)
+{
+    int c = 31 - __builtin_clz((unsigned)size);
+    return c < FIT_CLASSES ? c : FIT_CLASSES - 1;
+}
+
+static void class_push(FitHeapPtr h, MabPtr m)
+{
+    int c = fit_class(m->size);
+    m->prev_free = NULL;
+    m->next_free = h->free_list[c];
+    if (m->next_free)
+        m->next_free->prev_free = m;
+    h->free_list[c] = m;
+}
+
+static void class_remove(FitHeapPtr h, MabPtr m)
+{
+    if (m->prev_free)
+        m->prev_free->next_free = m->next_free;
+    else
+        h->free_list[fit_class(m->size)] = m->next_free;
+    if (m->next_free)
+        m->next_free->prev_free = m->prev_free;
+    m->prev_free = NULL;
+    m->next_free = NULL;
+}
+
+static MabPtr new_block(FitHeapPtr h, int offset, int size)
+{
+    MabPtr m = (MabPtr)poolAlloc(h->nodes);
+    if (m == NULL)
+    {
+        fprintf(stderr, "FATAL: malloc() not working");
+        exit(EXIT_FAILURE);
+    }
+    m->offset = offset;
+    m->size = size;
+    m->allocated = 0;
+    m->parent = &h->root;
+    m->left_child = NULL;
+    m->right_child = NULL;
+    m->prev_free = NULL;
+    m->next_free = NULL;
+    m->request = 0;
+    m->policy = h->root.policy;
+    return m;
+}
+
+// cut free block 'b' (off its class list) down to 'size', the rest becoming
+// a free block just above it; returns the rest, NULL if 'b' fits exactly
+static MabPtr cut_above(FitHeapPtr h, MabPtr b, int size)
+{
+    if (b->size == size)
+        return NULL;
+    MabPtr rest = new_block(h, b->offset + size, b->size - size);
+    rest->left_child = b;
+    rest->right_child = b->right_child;
+    if (b->right_child)
+        b->right_child->left_child = rest;
+    b->right_child = rest;
+    b->size = size;
+    if (h->root.policy == MEM_SEGREGATED)
+        class_push(h, rest);
+    h->stats.splits++;
+    return rest;
+}
+
+// count block 'b' of 'size' megabytes as allocated
+static void take_block(FitHeapPtr h, MabPtr b, int size)
+{
+    MabStatsPtr s = &h->stats;
+
+    b->allocated = 1;
+    b->request = size;
+    s->allocs++;
+    s->allocated += size;
+    s->requested += size;
+    s->free -= size;
+    if (s->allocated > s->peak_allocated)
+        s->peak_allocated = s->allocated;
+}
+
+// free block that 'size' goes into, NULL if there is none
+static MabPtr find_block(FitHeapPtr h, int size)
+{
+    MabPtr best = NULL;
+
+    switch (h->root.policy)
+    {
+        case MEM_SEGREGATED:
+            for (MabPtr m = h->free_list[fit_class(size)]; m; m = m->next_free)
+                if (m->size >= size)
+                    return m;
+            for (int c = fit_class(size) + 1; c < FIT_CLASSES; c++)
+                if (h->free_list[c])
+                    return h->free_list[c];
+            return NULL;
+        case MEM_FIRST_FIT:
+            for (MabPtr m = h->first; m; m = m->right_child)
+                if (!m->allocated && m->size >= size)
+                    return m;
+            return NULL;
+        default: // MEM_BEST_FIT
+            for (MabPtr m = h->first; m; m = m->right_child)
+                if (!m->allocated && m->size >= size && (!best || m->size < best->size))
+                    best = m;
+            return best;
+    }
+}
+
+/*******************************************************
+ * MabPtr fitInit(int policy, int offset, int size) - create
+ *    a fit heap of 'size' megabytes at 'offset', managed by
+ *    MEM_SEGREGATED, MEM_FIRST_FIT or MEM_BEST_FIT
+ *
+ * Returns:
+ *   The root of the heap or NULL if malloc failed.
+ ******************************************************/
+MabPtr fitInit(int policy, int offset, int size)
+{
+    FitHeapPtr h = (FitHeapPtr)calloc(1, sizeof(FitHeap));
+    if (h == NULL || !(h->nodes = poolCreate(sizeof(Mab), 64)))
+    {
+        fprintf(stderr, "ERROR: Could not create memory heap\n");
+        free(h);
+        return NULL;
+    }
+
+    h->root.offset = offset;
+    h->root.size = size;
+    h->root.policy = policy;
+    h->first = new_block(h, offset, size);
+    if (policy == MEM_SEGREGATED)
+        class_push(h, h->first);
+    h->stats.free = size;
+    h->stats.largest_free = size;
+
+    return &h->root;
+}
+
+/*******************************************************
+ * void fitClose(MabPtr m) - release the heap that 'm'
+ *    belongs to and every block of it
+ ******************************************************/
+void fitClose(MabPtr m)
+{
+    FitHeapPtr h = fit_heap(m);
+    poolDestroy(h->nodes);
+    free(h);
+}
+
+/*******************************************************
+ * PoolPtr fitPool(MabPtr m) - block pool of the heap
+ ******************************************************/
+PoolPtr fitPool(MabPtr m)
+{
+    return fit_heap(m)->nodes;
+}
+
+/*******************************************************
+ * MabStatsPtr fitStats(MabPtr m) - live counters of the
+ *    heap; largest_free is found by walking the blocks
+ ******************************************************/
+MabStatsPtr fitStats(MabPtr m)
+{
+    FitHeapPtr h = fit_heap(m);
+
+    h->stats.largest_free = 0;
+    for (MabPtr b = h->first; b; b = b->right_child)
+        if (!b->allocated && b->size > h->stats.largest_free)
+            h->stats.largest_free = b->size;
+    return &h->stats;
+}
+
+/*******************************************************
+ * void fitPrint(MabPtr m) - print every block of the heap
+ *    if 'm' is the root, else just block 'm'
+ ******************************************************/
+void fitPrint(MabPtr m)
+{
+    if (m->parent)
+    {
+        logPrintf("Offset: %d, Size: %d, Allocated: %d\n", m->offset, m->size, m->allocated);
+        return;
+    }
+    for (MabPtr b = fit_heap(m)->first; b; b = b->right_child)
+        logPrintf("Offset: %d, Size: %d, Allocated: %d\n", b->offset, b->size, b->allocated);
+}
+
+/*******************************************************
+ * void fitChanges(MabPtr m) - print the blocks the last
+ *    fitAlloc or fitFree changed: the allocated block and
+ *    the free rest it was cut from, or the free block left
+ *    after coalescing
+ ******************************************************/
+void fitChanges(MabPtr m)
+{
+    FitHeapPtr h = fit_heap(m);
+    for (int i = 0; i < h->changed_count; i++)
+    {
+        MabPtr c = h->changed[i];
+        logPrintf("Offset: %d, Size: %d, Allocated: %d\n", c->offset, c->size, c->allocated);
+    }
+}
+
+/*******************************************************
+ * MabPtr fitAlloc(MabPtr m, int size) - allocate 'size'
+ *    megabytes from the bottom of the block the policy
+ *    picks; the rest of it stays free
+ *
+ * Returns:
+ *   The allocated block or NULL if no free block is big enough.
+ ******************************************************/
+MabPtr fitAlloc(MabPtr m, int size)
+{
+    uint64_t start = memCycles();
+    FitHeapPtr h = fit_heap(m);
+    MabStatsPtr s = &h->stats;
+    MabPtr b = find_block(h, size);
+    MabPtr rest = NULL;
+
+    h->changed_count = 0;
+    if (b)
+    {
+        if (h->root.policy == MEM_SEGREGATED)
+            class_remove(h, b);
+        rest = cut_above(h, b, size); // the rest stays free just above
+        take_block(h, b, size);
+        h->changed[h->changed_count++] = b;
+        if (rest)
+            h->changed[h->changed_count++] = rest;
+    }
+    else
+    {
+        s->failures++;
+        s->failures_by_order[memOrder(size)]++;
+        if (s->free >= size)
+            s->fragmented++;
+    }
+
+    uint64_t cycles = memCycles() - start;
+    s->alloc_cycles += cycles;
+    if (cycles > s->alloc_cycles_max)
+        s->alloc_cycles_max = cycles;
+    return b;
+}
+
+/*******************************************************
+ * MabPtr fitAllocAt(MabPtr m, int offset, int size) -
+ *    allocate 'size' megabytes at 'offset' out of the free
+ *    block holding them (see memAllocAt); what is left
+ *    below and above stays free
+ *
+ * Returns:
+ *   The allocated block or NULL if that memory is not free.
+ ******************************************************/
+MabPtr fitAllocAt(MabPtr m, int offset, int size)
+{
+    FitHeapPtr h = fit_heap(m);
+    MabPtr b = h->first;
+
+    while (b && !(!b->allocated && b->offset <= offset && offset + size <= b->offset + b->size))
+        b = b->right_child;
+    if (!b)
+        return NULL;
+
+    if (h->root.policy == MEM_SEGREGATED)
+        class_remove(h, b);
+    if (b->offset < offset)
+    {
+        // the free part below keeps 'b', the rest is cut off above it
+        MabPtr below = b;
+        b = cut_above(h, below, offset - below->offset);
+        if (h->root.policy == MEM_SEGREGATED)
+        {
+            class_remove(h, b);
+            class_push(h, below);
+        }
+    }
+    cut_above(h, b, size);
+    take_block(h, b, size);
+    h->changed[0] = b;
+    h->changed_count = 1;
+    return b;
+}
+
+/*******************************************************
+ * int fitFreeOrder(MabPtr m, int * offsets, int max) -
+ *    MEM_SEGREGATED: list the free blocks class by class,
+ *    each class list from its head (see memFreeOrder).
+ *    First and best fit go by address, there is nothing
+ *    to list.
+ *
+ * Returns:
+ *   The number of free blocks, at most 'max' are listed.
+ ******************************************************/
+int fitFreeOrder(MabPtr m, int * offsets, int max)
+{
+    FitHeapPtr h = fit_heap(m);
+    int count = 0;
+
+    if (h->root.policy != MEM_SEGREGATED)
+        return 0;
+    for (int c = 0; c < FIT_CLASSES; c++)
+        for (MabPtr b = h->free_list[c]; b; b = b->next_free, count++)
+            if (count < max)
+                offsets[count] = b->offset - h->root.offset;
+    return count;
+}
+
+/*******************************************************
+ * int fitSetFreeOrder(MabPtr m, const int * offsets,
+ *    int count) - reorder the class lists as fitFreeOrder
+ *    listed them
+ *
+ * Returns:
+ *   TRUE, or FALSE if an offset is not that of a free block.
+ ******************************************************/
+int fitSetFreeOrder(MabPtr m, const int * offsets, int count)
+{
+    FitHeapPtr h = fit_heap(m);
+
+    if (h->root.policy != MEM_SEGREGATED)
+        return count == 0;
+    for (int i = count - 1; i >= 0; i--)
+    {
+        MabPtr b = h->first;
+        while (b && b->offset != h->root.offset + offsets[i])
+            b = b->right_child;
+        if (!b || b->allocated)
+            return FALSE;
+        class_remove(h, b);
+        class_push(h, b);
+    }
+    return TRUE;
+}
+
+/*******************************************************
+ * MabPtr fitFree(MabPtr m) - free block 'm' and coalesce
+ *    it with the free blocks just below and above
+ *
+ * returns: The free block 'm' ended up in.
+ ******************************************************/
+MabPtr fitFree(MabPtr m)
+{
+    uint64_t start = memCycles();
+    FitHeapPtr h = fit_heap(m);
+    MabStatsPtr s = &h->stats;
+    int segregated = h->root.policy == MEM_SEGREGATED;
+
+    m->allocated = 0;
+    s->frees++;
+    s->allocated -= m->size;
+    s->requested -= m->request;
+    s->free += m->size;
+
+    // 1. absorb the free block above
+    MabPtr above = m->right_child;
+    if (above && !above->allocated)
+    {
+        if (segregated)
+            class_remove(h, above);
+        m->size += above->size;
+        m->right_child = above->right_child;
+        if (above->right_child)
+            above->right_child->left_child = m;
+        poolFree(h->nodes, above);
+        s->merges++;
+    }
+
+    // 2. be absorbed by the free block below
+    MabPtr below = m->left_child;
+    if (below && !below->allocated)
+    {
+        if (segregated)
+            class_remove(h, below);
+        below->size += m->size;
+        below->right_child = m->right_child;
+        if (m->right_child)
+            m->right_child->left_child = below;
+        poolFree(h->nodes, m);
+        m = below;
+        s->merges++;
+    }
+
+    if (segregated)
+        class_push(h, m);
+    h->changed[0] = m;
+    h->changed_count = 1;
+
+    uint64_t cycles = memCycles() - start;
+    s->free_cycles += cycles;
+    if (cycles > s->free_cycles_max)
+        s->free_cycles_max = cycles;
+    return m;
+}
@@ -0,0 +1,239 @@
+/* Job latency metrics for MLQD dispatcher
+
+   Every finished job is added to log-bucketed histograms, overall, by
+   the queue level it finished in and by its memory size class. Memory
+   use is fixed however many jobs run; per-job records are only kept if
+   the caller streams them out (see the dispatcher's job_log).
+*/
+
+/* Include Files */
+#include <limits.h>
+#include "metrics.h"
+
+static const char * metric_names[METRICS] = { "turnaround", "wait", "response", "preemptions" };
+
+/*******************************************************
+ * static helpers - histogram bucket arithmetic
+ ******************************************************/
+
+static int hist_bucket(long value)
+{
+    if (value < HIST_LINEAR)
+        return value < 0 ? 0 : (int)value;
+    if (value > INT_MAX)
+        value = INT_MAX;
+
+    int e = 31 - __builtin_clz((unsigned)value); // value is in [2^e, 2^(e+1))
+    int sub = (int)(value >> (e - HIST_SUB_BITS)) & ((1 << HIST_SUB_BITS) - 1);
+    return HIST_LINEAR + (e - HIST_SUB_BITS - 1) * (1 << HIST_SUB_BITS) + sub;
+}
+
+// largest value that falls into bucket 'b'
+static long hist_upper(int b)
+{
+    if (b < HIST_LINEAR)
+        return b;
+
+    int e = (b - HIST_LINEAR) / (1 << HIST_SUB_BITS) + HIST_SUB_BITS + 1;
+    int sub = (b - HIST_LINEAR) % (1 << HIST_SUB_BITS);
+    long lower = (long)((1 << HIST_SUB_BITS) + sub) << (e - HIST_SUB_BITS);
+    return lower + (1L << (e - HIST_SUB_BITS)) - 1;
+}
+
+/*******************************************************
+ * void recordHist(LatencyHistPtr h, long value)
+ *    - add 'value' to histogram 'h', negative values
+ *      count as 0
+ ******************************************************/
+void recordHist(LatencyHistPtr h, long value)
+{
+    if (value < 0)
+        value = 0;
+    h->bucket[hist_bucket(value)]++;
+    h->sum += value;
+    if (!h->count || value > h->max)
+        h->max = value;
+    h->count++;
+}
+
+/*******************************************************
+ * long percentileHist(LatencyHistPtr h, double p)
+ *    - value at percentile 'p' (0 - 100) of 'h'
+ *
+ * returns:
+ *    upper bound of the bucket holding that rank, capped
+ *    at the largest value recorded
+ *    0 if nothing was recorded
+ ******************************************************/
+long percentileHist(LatencyHistPtr h, double p)
+{
+    long rank = (long)(p / 100.0 * h->count + 0.999999);
+    long seen = 0;
+
+    if (!h->count)
+        return 0;
+    if (rank < 1)
+        rank = 1;
+    for (int b = 0; b < HIST_BUCKETS; b++)
+    {
+        seen += h->bucket[b];
+        if (seen >= rank)
+            return hist_upper(b) < h->max ? hist_upper(b) : h->max;
+    }
+    return h->max;
+}
+
+/*******************************************************
+ * void recordJob(JobMetricsPtr m, PcbPtr p, int level,
+ *    int finish_time) - add the latencies of job 'p',
+ *    which finished in queue 'level' at 'finish_time'
+ ******************************************************/
+void recordJob(JobMetricsPtr m, PcbPtr p, int level, int finish_time)
+{
+    long values[METRICS];
+    int order = memOrder(p->mem_size);
+
+    values[METRIC_TURNAROUND] = finish_time - p->arrival_time;
+    values[METRIC_WAIT] = values[METRIC_TURNAROUND] - p->service_time;
+    values[METRIC_RESPONSE] = p->first_start_time - p->arrival_time;
+    values[METRIC_PREEMPTIONS] = p->preemptions;
+
+    for (int i = 0; i < METRICS; i++)
+    {
+        recordHist(&m->all[i], values[i]);
+        recordHist(&m->by_level[level][i], values[i]);
+        recordHist(&m->by_mem[order][i], values[i]);
+    }
+    m->jobs++;
+}
+
+/*******************************************************
+ * void printJobMetrics(JobMetricsPtr m) - print overall
+ *    mean and percentiles of every metric
+ ******************************************************/
+void printJobMetrics(JobMetricsPtr m)
+{
+    printf("\n%-12s %10s %8s %8s %8s %8s\n", "per job", "mean", "p50", "p90", "p99", "max");
+    for (int i = 0; i < METRICS; i++)
+    {
+        LatencyHistPtr h = &m->all[i];
+        printf("%-12s %10.3f %8ld %8ld %8ld %8ld\n", metric_names[i],
+            h->count ? h->sum / h->count : 0.0, percentileHist(h, 50),
+            percentileHist(h, 90), percentileHist(h, 99), h->max);
+    }
+}
+
+// one CSV row per metric of a histogram group
+static void csv_group(FILE * stream, const char * group, long key, LatencyHist hists[METRICS])
+{
+    for (int i = 0; i < METRICS; i++)
+    {
+        LatencyHistPtr h = &hists[i];
+        if (!h->count)
+            continue;
+        fprintf(stream, "%s,%ld,%s,%ld,%.3f,%ld,%ld,%ld,%ld\n", group, key, metric_names[i],
+            h->count, h->sum / h->count, percentileHist(h, 50), percentileHist(h, 90),
+            percentileHist(h, 99), h->max);
+    }
+}
+
+/*******************************************************
+ * int writeJobMetricsCsv(JobMetricsPtr m, char * path)
+ *    - write every histogram as "group,key,metric,count,
+ *      mean,p50,p90,p99,max" rows; group is all, level
+ *      (key 0 - 2) or mem (key is the block size in MB)
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int writeJobMetricsCsv(JobMetricsPtr m, char * path)
+{
+    FILE * stream = fopen(path, "w");
+    if (!stream)
+    {
+        fprintf(stderr, "ERROR: Could not create \"%s\"\n", path);
+        return FALSE;
+    }
+
+    fprintf(stream, "group,key,metric,count,mean,p50,p90,p99,max\n");
+    csv_group(stream, "all", 0, m->all);
+    for (int level = 0; level < LEVELS; level++)
+        csv_group(stream, "level", level, m->by_level[level]);
+    for (int order = 0; order < MAB_ORDERS; order++)
+        csv_group(stream, "mem", BLOCK_MIN_SIZE << order, m->by_mem[order]);
+
+    if (fclose(stream) != 0)
+    {
+        fprintf(stderr, "ERROR: Could not write \"%s\"\n", path);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+// one JSON object holding every metric of a histogram group
+static void json_group(FILE * stream, LatencyHist hists[METRICS])
+{
+    fprintf(stream, "{");
+    for (int i = 0; i < METRICS; i++)
+    {
+        LatencyHistPtr h = &hists[i];
+        fprintf(stream, "%s\"%s\": {\"count\": %ld, \"mean\": %.3f, \"p50\": %ld, "
+            "\"p90\": %ld, \"p99\": %ld, \"max\": %ld}", i ? ", " : "", metric_names[i],
+            h->count, h->count ? h->sum / h->count : 0.0, percentileHist(h, 50),
+            percentileHist(h, 90), percentileHist(h, 99), h->max);
+    }
+    fprintf(stream, "}");
+}
+
+/*******************************************************
+ * int writeJobMetricsJson(JobMetricsPtr m, char * path)
+ *    - write every histogram as one JSON object:
+ *      {"jobs", "all", "level": {"0".."2"}, "mem": {"8"..}}
+ *      with empty groups left out
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int writeJobMetricsJson(JobMetricsPtr m, char * path)
+{
+    FILE * stream = fopen(path, "w");
+    int first = TRUE;
+
+    if (!stream)
+    {
+        fprintf(stderr, "ERROR: Could not create \"%s\"\n", path);
+        return FALSE;
+    }
+
+    fprintf(stream, "{\n  \"jobs\": %ld,\n  \"all\": ", m->jobs);
+    json_group(stream, m->all);
+    fprintf(stream, ",\n  \"level\": {");
+    for (int level = 0; level < LEVELS; level++)
+    {
+        if (!m->by_level[level][0].count)
+            continue;
+        fprintf(stream, "%s\n    \"%d\": ", first ? "" : ",", level);
+        json_group(stream, m->by_level[level]);
+        first = FALSE;
+    }
+    fprintf(stream, "\n  },\n  \"mem\": {");
+    first = TRUE;
+    for (int order = 0; order < MAB_ORDERS; order++)
+    {
+        if (!m->by_mem[order][0].count)
+            continue;
+        fprintf(stream, "%s\n    \"%d\": ", first ? "" : ",", BLOCK_MIN_SIZE << order);
+        json_group(stream, m->by_mem[order]);
+        first = FALSE;
+    }
+    fprintf(stream, "\n  }\n}\n");
+
+    if (fclose(stream) != 0)
+    {
+        fprintf(stderr, "ERROR: Could not write \"%s\"\n", path);
+        return FALSE;
+    }
+    return TRUE;
+}
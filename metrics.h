@@ -0,0 +1,54 @@
+/* Job latency metrics include header file for MLQD dispatcher */
+
+#ifndef MLQD_METRICS
+#define MLQD_METRICS
+
+/* Include files */
+#include "pcb.h"
+#include "mab.h"
+
+/* Metrics Definitions ****************************************/
+#define METRIC_TURNAROUND 0 // finish - arrival
+#define METRIC_WAIT 1 // turnaround - service time
+#define METRIC_RESPONSE 2 // first dispatch - arrival
+#define METRIC_PREEMPTIONS 3 // times the job was suspended before it finished
+#define METRICS 4
+
+/* Histogram buckets: exact below 2^HIST_SUB_BITS+1, then 2^HIST_SUB_BITS
+   buckets per power of two, so a percentile is within 12.5% of the
+   true value (and never above the recorded maximum) */
+#define HIST_SUB_BITS 3
+#define HIST_LINEAR (2 << HIST_SUB_BITS)
+#define HIST_BUCKETS (HIST_LINEAR + (31 - HIST_SUB_BITS - 1) * (1 << HIST_SUB_BITS))
+
+/* Custom Data Types */
+struct latency_hist {
+    long count; // values recorded
+    long max; // largest value recorded
+    double sum; // for the mean
+    long bucket[HIST_BUCKETS];
+};
+
+typedef struct latency_hist LatencyHist;
+typedef LatencyHist * LatencyHistPtr;
+
+/* Fixed-size summary of every finished job, whatever the job count */
+struct job_metrics {
+    long jobs;
+    LatencyHist all[METRICS];
+    LatencyHist by_level[LEVELS][METRICS]; // by the queue level the job finished in
+    LatencyHist by_mem[MAB_ORDERS][METRICS]; // by memory size class (see memOrder)
+};
+
+typedef struct job_metrics JobMetrics;
+typedef JobMetrics * JobMetricsPtr;
+
+/* Function Prototypes */
+void   recordHist(LatencyHistPtr h, long value); // add one value
+long   percentileHist(LatencyHistPtr h, double p); // value below which 'p' percent fall
+void   recordJob(JobMetricsPtr m, PcbPtr p, int level, int finish_time); // add a finished job
+void   printJobMetrics(JobMetricsPtr m); // overall percentiles on stdout
+int    writeJobMetricsCsv(JobMetricsPtr m, char * path); // every breakdown as CSV
+int    writeJobMetricsJson(JobMetricsPtr m, char * path); // every breakdown as JSON
+
+#endif
@@ -3,113 +3,161 @@
     SID: 500436282
 
     usage:
-        ./mlqd <TESTFILE>
-        where <TESTFILE> is the name of a job list
+        ./mlqd [--simulate] [--cpus N] [--queues shared|per-cpu]
+               [--launch fork|spawn] [--spawn-pool N] [--max-bypass N]
+               [--jobs-csv FILE] [--metrics-csv FILE] [--metrics-json FILE]
+               [--trace FILE] [--trace-events N]
+               [--t0 LIST] [--t1 LIST] [--k LIST] [--threads N]
+               [--mem buddy|segregated|first-fit|best-fit] [--time-unit s|ms|us]
+               [--listen SOCKET] [--intake-max N] [--accounting wall|cpu]
+               [--checkpoint FILE] [--checkpoint-every N] [--restore FILE]
+               [--log quiet|jobs|memory|tree] <TESTFILE>
+        where <TESTFILE> is the name of a job list, either text
+        ("arrival, service, mem" lines) or binary (see jobconv);
+        it can be left out with --listen, and is left out with --restore
+
+        --simulate runs the same scheduling policy on a virtual clock:
+        no child processes are forked, no time is slept and idle gaps
+        between arrivals are skipped.
+
+        --cpus N runs up to N jobs at the same time (default 1). Every
+        CPU slot has its own running process and quantum, and idle slots
+        take work from the Level-0/1/2 queues in priority order.
+        --queues per-cpu gives every slot its own queues: jobs it suspends
+        stay on them and an idle slot steals from the tail of a peer's
+        queue. The default is one shared set of queues.
+
+        --launch chooses how new jobs are started: fork + execv, or
+        posix_spawn (default). --spawn-pool N keeps up to N stopped
+        ./process workers ready (max 64), so starting a job is a SIGCONT.
+
+        --max-bypass N lets later jobs that fit be admitted ahead of a
+        job blocked on memory at most N times (default 8), after which
+        admission waits for the blocked job. 0 disables backfilling.
+
+        Turnaround, wait, response time and preemptions of every job are
+        summarised at exit as mean/p50/p90/p99/max. --metrics-csv and
+        --metrics-json also write them broken down by the queue level the
+        job finished in and by memory size class; --jobs-csv writes one
+        line per job as it finishes.
+
+        --trace FILE records every arrival, admission, dispatch, suspension,
+        demotion, pre-emption, termination and memory allocation in a
+        preallocated ring of N events (--trace-events, default 262144) and
+        writes it to FILE at exit; see traceconv to view it in Perfetto.
+
+        --t0, --t1 and --k set the quanta and Level-1 iterations instead
+        of asking for them. Each takes a list of values and ranges, e.g.
+        "2", "1,2,4", "1-8" or "2-16:2". If the lists give more than one
+        combination, every combination is simulated (--simulate is implied)
+        on N threads (--threads, default one per online core) and a table
+        of runtime and turnaround/wait mean/p50/p90/p99/max is printed
+        instead of the usual report; the job list is loaded once and
+        shared by every thread.
+
+        --mem chooses how job memory is allocated: buddy blocks rounded
+        up to a power of two (default), or exact-size blocks coalesced on
+        free and found by segregated fit (per size class lists), first
+        fit or best fit. The report at exit adds the allocator counters,
+        the Arrived Queue delay and the time-averaged memory utilization;
+        see bench/policy_bench to compare the policies on the same jobs.
+
+        --time-unit sets the unit of the arrival and service times in the
+        job list, of t0 and t1 and of every time reported: s (default),
+        ms or us. In real time the quanta are timed on the monotonic
+        clock to that resolution. Times count up to 2147483646 units
+        (about 35 minutes in us): jobs that would end later are refused,
+        and a run still going then stops with an error.
+
+        A job that reaches Level-0 while every CPU slot is busy pre-empts
+        a Level-2 job, else a Level-1 job, at once; a pre-empted Level-1
+        job gets the rest of its quantum when it is resumed, and is
+        charged exactly the time it ran.
+
+        --listen SOCKET also takes jobs while the dispatcher runs, from
+        clients of a Unix socket (see jobsend and intake.h). A submitted
+        job arrives when the dispatcher reads it. The dispatcher runs
+        until a client closes the intake and every job has finished.
+        Clients are held back while N jobs (--intake-max, default 4096)
+        have been submitted but not admitted. Not with --simulate or a
+        sweep.
+
+        --accounting chooses what a running job is charged against its
+        service time: the wall-clock time it held its CPU slot (wall, the
+        default), or the CPU time its process actually consumed (cpu),
+        so that time it spent descheduled on a busy host is not charged.
+        With cpu a quantum is stretched until the process has used it,
+        to at most 4 times its length in wall time; a process that
+        sleeps (like ./process) is charged a quarter of the wall time.
+        The report at exit and --jobs-csv (consumed) give the CPU time
+        every process consumed, from wait4, next to what it was charged.
+        Not with --simulate.
+
+        --checkpoint FILE writes a snapshot of the dispatcher to FILE
+        whenever it receives SIGUSR1, and every N time units with
+        --checkpoint-every N: every queued job with its level, Level-1
+        rounds and memory block, the running slots, the timer and the
+        counters reported at exit. A forked child writes it while the
+        dispatcher runs on, and replaces FILE only once it is complete.
+        --restore FILE carries on from a snapshot instead of a job list,
+        with its slots, queue layout, memory policy, time unit, quanta
+        and k (those options are ignored). In real time the job processes
+        of the old dispatcher that still run are taken over by pid; the
+        rest start again. Jobs finished after the snapshot are run again.
+        --jobs-csv appends to its file when restoring.
+
+        --log sets what is printed while the dispatcher runs: nothing
+        (quiet), every started job (jobs), those plus the memory blocks
+        each allocation and free changed (memory, the default), or the
+        whole buddy tree after every change (tree). The lines are
+        buffered and written by a separate thread. quiet also leaves
+        out the line --restore prints about the snapshot it read.
 */
 
 /* Include files */
-#include "pcb.h"
-#include "mab.h"
-
-/***    USER FUNCTIONS (to reduce repeated code)    ***/ 
-
-// 1. job_arrival - checks for 'arrival' of incoming jobs
-int job_arrival(PcbPtr* job_queue, PcbPtr* arrived_queue, PcbPtr* process, int timer) 
-{
-    // If a new job has 'arrived'
-    if (*job_queue && (*job_queue)->arrival_time <= timer) {
-        // Dequeue the ready process from job_queue, and enqueue it to the arrived_queue
-        *process = deqPcb(job_queue);
-        *arrived_queue = enqPcb(*arrived_queue, *process);
-        return 1;
-    }
-    return 0;
-}
-
-// 2. allocate_job - allocate memory for a job before enqueueing it to the Level0_queue
-int allocate_job(PcbPtr* arrived_queue, PcbPtr* arrived_head, PcbPtr* level0_queue, MabPtr* first_block, PcbPtr* process) 
-{
-    if (*arrived_queue || *arrived_head) 
-    {
-        if (*arrived_head) 
-        {
-            *process = *arrived_head;
-            *arrived_head = NULL;
-        } else {
-            *process = deqPcb(arrived_queue);
-        }
-
-        MabPtr allocated_block = memAlloc(*first_block, (*process)->mem_block->size);
-        if (allocated_block) {
-            (*process)->mem_block = allocated_block;
-            *level0_queue = enqPcb(*level0_queue, *process);
-            
-            printf("\n");
-            print_mem_info(*first_block);
-
-            return 1;
-        }
-
-        // Allocation failed - put process back at head of queue
-        *arrived_head = *process;
-    }
-    return 0;
-}
-
-// 2. terminate_job - ensures proper termination of a finished job
-void terminate_job(PcbPtr* current_process, int timer, double* av_turnaround_time, double* av_wait_time) {
-    // A. Terminate the process
-    terminatePcb(*current_process);
-
-    // B. Calculate and accumulate turnaround time and wait time
-    int turnaround_time = timer - (*current_process)->arrival_time;
-    *av_turnaround_time += turnaround_time;
-    *av_wait_time += turnaround_time - (*current_process)->service_time;
-
-    // C. Deallocate the PCB's memory
-    memFree((*current_process)->mem_block);
-    
-    free(*current_process);
-    *current_process = NULL;
-}
+#include "dispatcher.h"
+#include "jobfile.h"
+#include "reactor.h"
+#include "trace.h"
+#include "sweep.h"
+#include "intake.h"
+#include "checkpoint.h"
+#include <string.h>
+
+static int simulate = FALSE; // TRUE: run on a virtual clock (--simulate)
+static int spawn_pool = 0; // --spawn-pool, pre-spawned ./process workers
+static int t0_list[SWEEP_VALUES_MAX], t1_list[SWEEP_VALUES_MAX], k_list[SWEEP_VALUES_MAX]; // --t0/--t1/--k
 
 /***    MAIN FUNCTION   ***/ 
 
 int main (int argc, char *argv[])
 {
     /*** Main function variable declarations ***/
-    FILE * input_list_stream = NULL;
-    PcbPtr job_queue = NULL;
-    PcbPtr arrived_queue = NULL; 
-    PcbPtr level0_queue = NULL;
-    PcbPtr level1_queue = NULL;
-    PcbPtr level2_queue = NULL;
-
-    PcbPtr current_process = NULL;
-    PcbPtr process = NULL;
-
-    PcbPtr arrived_head = NULL; // stores the pre-empted process for the Arrived Queue 
-    PcbPtr level2_head = NULL; // stores the pre-empted process for the Level-2 Queue 
-
-    // Initialise global memory of 2048 megabytes
-    MabPtr first_block = (MabPtr)malloc(sizeof(Mab));
-    first_block->offset = (uintptr_t)(malloc(2048)); /* assume this refers to megabytes.
-                                        if this were real it would be malloc(2 * 1024^3) */
-    first_block->size = 2048;
-    first_block->allocated = 0;
-    first_block->parent = NULL;
-    first_block->left_child = NULL;
-    first_block->right_child = NULL;
-
-    int timer = 0;
-    int t0; // time quantum for Level-0 queue
-    int t1; // time quantum for Level-1 queue
-    int k;  // number of iterations for a job to stay in the Level-1 queue
-    int quantum; // temp value used to calculate exact time passed for the Level-1 Queue 
-
-    int turnaround_time;
+    static Dispatcher dispatcher;
+    Dispatcher* d = &dispatcher;
+
+    int cpus = 1; // CPU slots
+    int layout = QUEUES_SHARED;
+    int mem_policy = MEM_BUDDY;
+    int time_unit = TIME_S;
+    int accounting = ACCOUNT_WALL;
+    char * listen_path = NULL; // submission socket
+    long intake_max = INTAKE_MAX_PENDING;
+    int max_bypass = BACKFILL_MAX_BYPASS;
+    char * jobs_csv = NULL; // per-job records
+    char * metrics_csv = NULL; // percentile summaries
+    char * metrics_json = NULL;
+    char * trace_file = NULL;
+    int trace_events = TRACE_DEFAULT_EVENTS;
+    char * checkpoint_file = NULL; // snapshots written
+    int checkpoint_every = 0;
+    char * restore_file = NULL; // snapshot to carry on from
+    int t0_count = 0, t1_count = 0, k_count = 0; // values given on the command line
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN); // sweep workers
     double av_turnaround_time = 0.0, av_wait_time = 0.0;
     int n = 0;
+    int finished; // TRUE if runDispatcher ran every job to completion
+    char * job_file = NULL;
 
 
 //  1. Populate the job queue
@@ -118,270 +166,416 @@ int main (int argc, char *argv[])
         fprintf(stderr, "FATAL: Bad arguments array\n");
         exit(EXIT_FAILURE);
     }
-    else if (argc != 2)
+
+    for (int i = 1; i < argc; i++)
     {
-        fprintf(stderr, "Usage: %s <TESTFILE>\n", argv[0]);
-        exit(EXIT_FAILURE);
+        if (strcmp(argv[i], "--simulate") == 0)
+            simulate = TRUE;
+        else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc)
+        {
+            char * end;
+            cpus = (int)strtol(argv[++i], &end, 10);
+            if (*end || cpus < 1 || cpus > CPU_SLOTS_MAX)
+            {
+                job_file = NULL; // bad slot count
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--queues") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "shared") == 0)
+                layout = QUEUES_SHARED;
+            else if (strcmp(argv[i], "per-cpu") == 0)
+                layout = QUEUES_PER_CPU;
+            else
+            {
+                job_file = NULL; // unknown queue layout
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--launch") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "fork") == 0)
+                setPcbLaunch(LAUNCH_FORK);
+            else if (strcmp(argv[i], "spawn") == 0)
+                setPcbLaunch(LAUNCH_SPAWN);
+            else
+            {
+                job_file = NULL; // unknown launch path
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--spawn-pool") == 0 && i + 1 < argc)
+        {
+            char * end;
+            spawn_pool = (int)strtol(argv[++i], &end, 10);
+            if (*end || spawn_pool < 0 || spawn_pool > SPAWN_POOL_MAX)
+            {
+                job_file = NULL; // bad pool size
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--max-bypass") == 0 && i + 1 < argc)
+        {
+            char * end;
+            max_bypass = (int)strtol(argv[++i], &end, 10);
+            if (*end || max_bypass < 0)
+            {
+                job_file = NULL; // bad bypass count
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--jobs-csv") == 0 && i + 1 < argc)
+            jobs_csv = argv[++i];
+        else if (strcmp(argv[i], "--metrics-csv") == 0 && i + 1 < argc)
+            metrics_csv = argv[++i];
+        else if (strcmp(argv[i], "--metrics-json") == 0 && i + 1 < argc)
+            metrics_json = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+            trace_file = argv[++i];
+        else if (strcmp(argv[i], "--trace-events") == 0 && i + 1 < argc)
+        {
+            char * end;
+            trace_events = (int)strtol(argv[++i], &end, 10);
+            if (*end || trace_events < 1 || trace_events > (1 << 30))
+            {
+                job_file = NULL; // bad trace size
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--t0") == 0 && i + 1 < argc)
+        {
+            if ((t0_count = parseSweepList(argv[++i], t0_list, SWEEP_VALUES_MAX)) < 0)
+            {
+                job_file = NULL; // bad t0 list
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--t1") == 0 && i + 1 < argc)
+        {
+            if ((t1_count = parseSweepList(argv[++i], t1_list, SWEEP_VALUES_MAX)) < 0)
+            {
+                job_file = NULL; // bad t1 list
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--k") == 0 && i + 1 < argc)
+        {
+            if ((k_count = parseSweepList(argv[++i], k_list, SWEEP_VALUES_MAX)) < 0)
+            {
+                job_file = NULL; // bad k list
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--mem") == 0 && i + 1 < argc)
+        {
+            if (!parseMemPolicy(&mem_policy, argv[++i]))
+            {
+                job_file = NULL; // unknown allocation policy
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--time-unit") == 0 && i + 1 < argc)
+        {
+            if (!parseTimeUnit(&time_unit, argv[++i]))
+            {
+                job_file = NULL; // unknown time unit
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--listen") == 0 && i + 1 < argc)
+            listen_path = argv[++i];
+        else if (strcmp(argv[i], "--accounting") == 0 && i + 1 < argc)
+        {
+            i++;
+            if (strcmp(argv[i], "wall") == 0)
+                accounting = ACCOUNT_WALL;
+            else if (strcmp(argv[i], "cpu") == 0)
+                accounting = ACCOUNT_CPU;
+            else
+            {
+                job_file = NULL; // unknown accounting
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0 && i + 1 < argc)
+            checkpoint_file = argv[++i];
+        else if (strcmp(argv[i], "--checkpoint-every") == 0 && i + 1 < argc)
+        {
+            char * end;
+            checkpoint_every = (int)strtol(argv[++i], &end, 10);
+            if (*end || checkpoint_every < 1)
+            {
+                job_file = NULL; // bad snapshot interval
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--restore") == 0 && i + 1 < argc)
+            restore_file = argv[++i];
+        else if (strcmp(argv[i], "--intake-max") == 0 && i + 1 < argc)
+        {
+            char * end;
+            intake_max = strtol(argv[++i], &end, 10);
+            if (*end || intake_max < 1)
+            {
+                job_file = NULL; // bad intake limit
+                break;
+            }
+        }
+        else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc)
+        {
+            int level;
+            if (!parseLogLevel(&level, argv[++i]))
+            {
+                job_file = NULL; // unknown verbosity
+                break;
+            }
+            logSetLevel(level);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            char * end;
+            threads = (int)strtol(argv[++i], &end, 10);
+            if (*end || threads < 1 || threads > SWEEP_THREADS_MAX)
+            {
+                job_file = NULL; // bad thread count
+                break;
+            }
+        }
+        else if (!job_file)
+            job_file = argv[i];
+        else
+        {
+            job_file = NULL; // more than one job list given
+            listen_path = NULL;
+            break;
+        }
     }
-
-    if (!(input_list_stream = fopen(argv[1], "r")))
+    if ((!job_file && !listen_path && !restore_file) || (job_file && restore_file)
+        || ((listen_path || accounting == ACCOUNT_CPU) && simulate) || (checkpoint_every && !checkpoint_file))
     {
-        fprintf(stderr, "ERROR: Could not open \"%s\"\n", argv[1]);
+        fprintf(stderr, "Usage: %s [--simulate] [--cpus N] [--queues shared|per-cpu] "
+            "[--launch fork|spawn] [--spawn-pool N] [--max-bypass N] [--jobs-csv FILE] "
+            "[--metrics-csv FILE] [--metrics-json FILE] [--trace FILE] [--trace-events N] "
+            "[--t0 LIST] [--t1 LIST] [--k LIST] [--threads N] "
+            "[--mem buddy|segregated|first-fit|best-fit] [--time-unit s|ms|us] "
+            "[--listen SOCKET] [--intake-max N] [--accounting wall|cpu] [--checkpoint FILE] "
+            "[--checkpoint-every N] [--restore FILE] [--log quiet|jobs|memory|tree] "
+            "<TESTFILE>\n", argv[0]);
         exit(EXIT_FAILURE);
     }
+    setPcbSimulated(simulate);
 
-    while (!feof(input_list_stream)) {  // put processes into job_queue
-        process = createnullPcb();
-        process->mem_block = (MabPtr)malloc(sizeof(Mab));
-        if (fscanf(input_list_stream,"%d, %d, %d",
-             &(process->arrival_time), &(process->service_time), &(process->mem_block->size)) != 3) {
-            free(process);
-            continue;
-        }
+    if (restore_file)
+    {
+        // Carry on from a snapshot, with its settings, quanta and k
+        if (!checkpointRestore(d, restore_file, simulate))
+            exit(EXIT_FAILURE);
+        time_unit = d->time_unit;
+        t0_list[0] = d->t0;
+        t1_list[0] = d->t1;
+        k_list[0] = d->k;
+        t0_count = t1_count = k_count = 1;
+    }
+    else
+    {
+        if (!initDispatcher(d, cpus, layout, mem_policy))
+            exit(EXIT_FAILURE);
+        d->simulate = simulate;
+        d->time_unit = time_unit;
+        d->accounting = accounting;
+        d->max_bypass = max_bypass;
 
-        if (process->arrival_time < 0 || process->service_time < 0 ||
-            process->mem_block->size < 0 || process->mem_block->size > 2048) {
-            fprintf(stderr, "ERROR: Job file %s has invalid entries.\n", argv[1]);
+        if (job_file && (n = loadJobList(job_file, &d->job_queue)) < 0)
             exit(EXIT_FAILURE);
-        }
-    
-	    process->remaining_cpu_time = process->service_time;
-        process->status = PCB_INITIALIZED;
-        job_queue = enqPcb(job_queue, process);
-	n++;
+        d->jobs = n;
     }
 
-//  2. Ask the user to specify values for 't0', 't1' and 'k'
+//  2. Ask the user to specify values for 't0', 't1' and 'k' not given on the command line
 
     // Input validation for t0 (time quantum for Level-0 queue)
-    printf("Please enter a positive integer as the time quantum for the Level-0 queue: ");
-    if (scanf("%d", &t0) != 1 || t0 <= 0) {
-        fprintf(stderr, "Invalid input. Please enter a positive integer.\n");
-        exit(EXIT_FAILURE);
+    if (!t0_count) {
+        printf("Please enter a positive integer as the time quantum for the Level-0 queue: ");
+        if (scanf("%d", &t0_list[0]) != 1 || t0_list[0] <= 0) {
+            fprintf(stderr, "Invalid input. Please enter a positive integer.\n");
+            exit(EXIT_FAILURE);
+        }
+        t0_count = 1;
     }
 
     // Input validation for t1 (time quantum for Level-1 queue)
-    printf("Please enter a positive integer as the time quantum for the Level-1 queue: ");
-    if (scanf("%d", &t1) != 1 || t1 <= 0) {
-        fprintf(stderr, "Invalid input. Please enter a positive integer.\n");
-        exit(EXIT_FAILURE);
+    if (!t1_count) {
+        printf("Please enter a positive integer as the time quantum for the Level-1 queue: ");
+        if (scanf("%d", &t1_list[0]) != 1 || t1_list[0] <= 0) {
+            fprintf(stderr, "Invalid input. Please enter a positive integer.\n");
+            exit(EXIT_FAILURE);
+        }
+        t1_count = 1;
     }
 
     // Input validation for k (max number of iterations a job can stay in the Level-1 queue)
-    printf("Please enter a positive integer to specify the max number of iterations a job can stay in the Level-1 queue: ");
-    if (scanf("%d", &k) != 1 || k <= 0) {
-        fprintf(stderr, "Invalid input. Please enter a positive integer.\n");
-        exit(EXIT_FAILURE);
+    if (!k_count) {
+        printf("Please enter a positive integer to specify the max number of iterations a job can stay in the Level-1 queue: ");
+        if (scanf("%d", &k_list[0]) != 1 || k_list[0] <= 0) {
+            fprintf(stderr, "Invalid input. Please enter a positive integer.\n");
+            exit(EXIT_FAILURE);
+        }
+        k_count = 1;
     }
 
-//  3. Level-0 Queue: High Priority First-Come-First-Served 
-    while (1)
-    {   
-        
-//      i. If there is a currently running process:
-        if (current_process)
+    // More than one combination: simulate them all on the worker threads and print the table
+    if ((long)t0_count * t1_count * k_count > 1)
+    {
+        static Sweep sweep;
+        long points = (long)t0_count * t1_count * k_count;
+
+        if (listen_path)
         {
-//          a. Decrement the process's remaining_cpu_time variable;
-            current_process->remaining_cpu_time--;
-            
-//          b. If the process's allocated time has expired:
-            if (current_process->remaining_cpu_time <= 0)
-                terminate_job(&current_process, timer, &av_turnaround_time, &av_wait_time);
-
-//          c. Else if the process cannot finish within the time-quantum 't0':
-            else if ((timer - current_process->start_time) >= t0)
-            {
-//              A. Suspend the current process and enqueue it to the Level-1 Queue   
-                suspendPcb(current_process);
-                current_process->max_iterations = k;
-                level1_queue = enqPcb(level1_queue, current_process);
-                current_process = NULL;
-            }
+            fprintf(stderr, "ERROR: --listen takes one value of t0, t1 and k\n");
+            exit(EXIT_FAILURE);
         }
-
-//      ii. Terminate MLQD Dispatcher if it reenters Level-0 with no jobs left to run
-        if (!(job_queue || arrived_queue || arrived_head || level0_queue 
-        || level1_queue || level2_queue || level2_head || current_process))
-            break; 
-
-//      iii. If the next job 'arrives', add it to the Level-0 Queue
-        job_arrival(&job_queue, &arrived_queue, &process, timer);
-
-//      iv. If memory can be allocated for the next job in Arrived Queue, 
-//              dequeue it from Arrived Queue and add it to Level-0 Queue
-        allocate_job(&arrived_queue, &arrived_head, &level0_queue, &first_block, &process);
-
-//      v. If no current_process && Level-0 Queue is not empty:
-        if (!current_process && level0_queue)
-        {   
-//          a. Dequeue a process from the Level-0 Queue, set it as currently running and start it
-            current_process = deqPcb(&level0_queue);
-            current_process->start_time = timer;
-            startPcb(current_process);
+        if (accounting == ACCOUNT_CPU)
+        {
+            fprintf(stderr, "ERROR: --accounting cpu takes one value of t0, t1 and k\n");
+            exit(EXIT_FAILURE);
         }
-
-//      vi. Else if there are no jobs in the Level-0 Queue
-//              and there is a job in the Level-1 Queue:
-        else if (!current_process && !level0_queue && level1_queue) 
+        if (checkpoint_file)
         {
-//          4. Level-1 Queue: Round-Robin
-            while (current_process || level1_queue) 
-            {
-//              i. If a process is currently running:
-                if (current_process) 
-                { 
-//                  a. Decrement process remaining cpu time by quantum(may not be the same as 't1')
-                    current_process->remaining_cpu_time -= quantum;
-
-//                  b. Increment number of completed iterations for current process
-                    current_process->curr_iterations += 1;
-
-//                  c. If the process's allocated time has expired:
-                    if (current_process->remaining_cpu_time <= 0) 
-                        terminate_job(&current_process, timer, &av_turnaround_time, &av_wait_time);
-
-//                  d. Else if the current process cannot be completed after k iterations
-                    else if (current_process->curr_iterations == current_process->max_iterations)
-                    {
-//                      A. Suspend the current process and enqueue it to the Level-1 Queue   
-                        suspendPcb(current_process);
-                        level2_queue = enqPcb(level2_queue, current_process);
-                        current_process = NULL;
-                    } 
-
-//                  e. Else if the current process is between 0 and k iterations
-                    else 
-                    {
-//                      A. Suspend the current process and enqueue it back Level-1 Queue
-                        suspendPcb(current_process);
-                        level1_queue = enqPcb(level1_queue, current_process);
-                        current_process = NULL;
-                    }
-                }
-
-//              ii. If the next job 'arrives', add it to the Arrived Queue
-                job_arrival(&job_queue, &arrived_queue, &process, timer);
-
-//              iii. If memory can be allocated for the next job in Arrived Queue, 
-//                      dequeue it from Arrived Queue and add it to Level-0 Queue
-                if (allocate_job(&arrived_queue, &arrived_head, &level0_queue, &first_block, &process))
-                    break;
-
-//              iv. If no current_process and Level-1 Queue is empty, either:
-//                      a. Instantly terminate MLQD Dispatcher (all jobs finished)
-//                      b. go directly to 5. to keep time flow consistent (enters Level-2)
-                if (!current_process && !level1_queue)
-                    break; // go back to 3.
-                
-//              v. If no current_process && Level-1 Queue is not empty:
-                if (!current_process && level1_queue) 
-                {
-//                  a. Dequeue process from Level-1 Queue, set it as currently running porcess
-                    current_process = deqPcb(&level1_queue);
-                    current_process->start_time = timer;
-                    
-//                  b. If already started but suspended, restart it (send SIGCONT to it)
-//                          else start it (fork & exec)
-                    startPcb(current_process);
-                }
-                
-//              vi. Sleep for quantum(may not be the same as 't1') and increment dispatcher timer
-                quantum = current_process && current_process->remaining_cpu_time < t1 ?
-                                current_process->remaining_cpu_time :
-                                !(current_process) ? 1 : t1;
-                sleep(quantum);
-                timer += quantum;
-            }
-            continue; 
+            fprintf(stderr, "ERROR: --checkpoint takes one value of t0, t1 and k\n");
+            exit(EXIT_FAILURE);
         }
-
-//      vii. Else if there are no jobs in the Level-0 and Level-1 Queues
-//           and there is a job in the Level-2 Queue:
-        else if (!current_process && !level0_queue && !level1_queue && (level2_queue || level2_head))
-        {   
-//          5. Level-2 Queue: Low Priority First-Come-First-Served
-            while (current_process || level2_head || level2_queue)
-            {
-//              i. If there is a currently running process:
-                if (current_process)
-                {
-//                  a. Decrement the process's remaining_cpu_time variable;
-                    current_process->remaining_cpu_time--;
-
-//                  b. If the process's allocated time has expired:
-                    if (current_process->remaining_cpu_time <= 0)
-                    {
-                        terminate_job(&current_process, timer, &av_turnaround_time, &av_wait_time);
-                        level2_head = NULL;
-                    }
-                }
-
-//              ii. If the next job 'arrives', add it to the Arrived Queue
-                job_arrival(&job_queue, &arrived_queue, &process, timer);
-
-//              iii. If memory can be allocated for the next job in Arrived Queue, 
-//                      dequeue it from Arrived Queue, add it to Level-0 Queue and run it instantly
-                if (allocate_job(&arrived_queue, &arrived_head, &level0_queue, &first_block, &process)) 
-                {                
-//                  a. Suspend current process and put it at head of Level-2 Queue
-                    if (current_process) 
-                    {
-                        suspendPcb(current_process);
-                        level2_head = current_process;
-                        current_process = NULL;
-                    }
-                    break; // go back to 3. 
-                }
-
-//              iv. If a job was pre-empted, restart it and set is as currently running
-                if (level2_head) 
+        if (points > SWEEP_POINTS_MAX)
+        {
+            fprintf(stderr, "ERROR: %ld combinations of t0, t1 and k, at most %d can be swept\n",
+                points, SWEEP_POINTS_MAX);
+            exit(EXIT_FAILURE);
+        }
+        if (!loadSweepJobs(&sweep, &d->job_queue)
+            || !(sweep.points = (SweepPointPtr)calloc(points, sizeof(SweepPoint))))
+            exit(EXIT_FAILURE);
+        sweep.cpus = cpus;
+        sweep.layout = layout;
+        sweep.mem_policy = mem_policy;
+        sweep.max_bypass = max_bypass;
+        for (int a = 0; a < t0_count; a++)
+            for (int b = 0; b < t1_count; b++)
+                for (int c = 0; c < k_count; c++)
                 {
-//                  a. 'Dequeue' process from level2_head, set it as currently running process
-                    current_process = level2_head;
-                    level2_head = NULL;
-//                  b. Process is currently suspended, restart it (send SIGCONT to it) 
-                    startPcb(current_process);
+                    SweepPointPtr pt = &sweep.points[sweep.count++];
+                    pt->t0 = t0_list[a];
+                    pt->t1 = t1_list[b];
+                    pt->k = k_list[c];
                 }
+        closeDispatcher(d);
+        if (!runSweep(&sweep, threads))
+            exit(EXIT_FAILURE);
+        printf("\n%d jobs, %d combinations, %d cpus\n", sweep.jobs, sweep.count, cpus);
+        printSweep(&sweep);
+        free(sweep.points);
+        free(sweep.records);
+        exit(EXIT_SUCCESS);
+    }
+    d->t0 = t0_list[0];
+    d->t1 = t1_list[0];
+    d->k = k_list[0];
 
-//              v. Else if no current_process and Level-2 Queue is empty, either:
-//                      a. Instantly terminate MLQD Dispatcher (all jobs finished)
-//                      b. Wait for incoming jobs to arrive
-                else if (!current_process && !level2_queue)
-                    break; // go back to 3. 
-
-//              vi. Else if no current_process && Level-2 Queue is not empty:
-                else if (!current_process && level2_queue) 
-                {
-//                  a. Dequeue process from Level-1 Queue, set it as currently running process
-                    current_process = deqPcb(&level2_queue);
-                    current_process->start_time = timer;
-
-//                  b. If already started but suspended, restart it (send SIGCONT to it)
-//                          else start it (fork & exec)
-                    startPcb(current_process);
-                }                
-
-//              vii. Sleep for one second and increment dispatcher timer
-                sleep(1);
-                timer++;
-            }
-            continue;
+    if (jobs_csv)
+    {
+        // a restored run adds the jobs it finishes to those of the run it carries on
+        if (!(d->job_log = fopen(jobs_csv, restore_file ? "a" : "w")))
+        {
+            fprintf(stderr, "ERROR: Could not create \"%s\"\n", jobs_csv);
+            exit(EXIT_FAILURE);
         }
+        if (ftell(d->job_log) == 0)
+            fprintf(d->job_log, "arrival,service,mem,turnaround,wait,response,preemptions,level,cpu,consumed\n");
+    }
 
-//      viii. Sleep for one second and increment dispatcher timer
-        sleep(1);
-        timer++;
+    if (trace_file && !traceInit(trace_events, (uint32_t)(timeUnitSeconds(time_unit) * 1e6)))
+        exit(EXIT_FAILURE);
 
-//      go back to 3.
-    }
+    // Real time runs on the event reactor, starting now
+    if (!simulate && !reactorInit())
+        exit(EXIT_FAILURE);
+    if (!simulate && restore_file)
+        reactorSetElapsed(d->timer * timeUnitSeconds(d->time_unit));
+    if (checkpoint_file && !checkpointInit(d, checkpoint_file, checkpoint_every))
+        exit(EXIT_FAILURE);
+    if (listen_path && (!(d->intake = intakeCreate(intake_max))
+        || !intakeListen(d->intake, listen_path) || !reactorWatch(d->intake->wake_fd)))
+        exit(EXIT_FAILURE);
+    initSpawnPool(spawn_pool);
+    if (!logStart(stdout))
+        exit(EXIT_FAILURE);
 
-//  6. Print out the total run time, average turnaround time and average wait time
-    printf("\ntotal runtime = %i\n", timer);
-    av_turnaround_time = av_turnaround_time / n;
-    av_wait_time = av_wait_time / n;
+//  3. - 6. Run the Level-0/1/2 queues until every job has finished (see dispatcher.c)
+    finished = runDispatcher(d);
+    checkpointFinish(d);
+    logStop(); // the report below goes straight to stdout
+
+//  7. Print out the total run time, average turnaround time and average wait time
+    if (time_unit != TIME_S)
+        printf("\ntimes in %s", timeUnitName(time_unit));
+    printf("\ntotal runtime = %i\n", d->timer);
+    n = 0; // jobs that finished, the others have no turnaround or wait time
+    for (int i = 0; i < d->cpus; i++)
+    {
+        av_turnaround_time += d->slots[i].turnaround_time;
+        av_wait_time += d->slots[i].wait_time;
+        n += d->slots[i].completed;
+    }
+    if (n)
+    {
+        av_turnaround_time = av_turnaround_time / n;
+        av_wait_time = av_wait_time / n;
+    }
     printf("average turnaround time = %f\n", av_turnaround_time);
     printf("average wait time = %f\n", av_wait_time);
+    if (d->cpus > 1)
+    {
+        for (int i = 0; i < d->cpus; i++)
+        {
+            CpuSlot* slot = &d->slots[i];
+            int jobs = slot->completed ? slot->completed : 1;
+            printf("cpu %d: %d jobs, average turnaround time = %f, average wait time = %f\n",
+                i, slot->completed, slot->turnaround_time / jobs, slot->wait_time / jobs);
+        }
+        printf("%ld steals, %ld migrations\n", d->steals, d->migrations);
+    }
+    printJobMetrics(&d->metrics);
+    printMemStats(d->first_block);
+    printMemUsage(d);
+    printCpuAccounting(d);
+    printWaitHist(d);
+    printLaunchStats();
+    if (d->intake)
+        printf("Intake: %ld jobs submitted, %ld lines rejected, clients held back %ld times\n",
+            d->intake->submitted, d->intake->rejected, d->intake->held);
+    if (d->checkpoint_path)
+        printf("Snapshots: %ld written to \"%s\"\n", d->checkpoints, d->checkpoint_path);
+    if (getPcbPool()) // not created when no job was ever queued
+        printf("Pcb pool: peak %d, live %d, heap chunks %d\n",
+            getPcbPool()->peak, getPcbPool()->live, getPcbPool()->chunk_count);
+    if (memPool(d->first_block)) // the bitmap heap has no node pool
+        printf("Mab pool: peak %d, live %d, heap chunks %d\n",
+            memPool(d->first_block)->peak, memPool(d->first_block)->live, memPool(d->first_block)->chunk_count);
     
-//  7. Terminate the MLQD dispatcher
-    exit(EXIT_SUCCESS);
-}
\ No newline at end of file
+    if (metrics_csv)
+        writeJobMetricsCsv(&d->metrics, metrics_csv);
+    if (metrics_json)
+        writeJobMetricsJson(&d->metrics, metrics_json);
+    if (d->job_log)
+        fclose(d->job_log);
+    if (trace_file)
+        traceWrite(trace_file);
+    traceClose();
+
+//  8. Terminate the MLQD dispatcher
+    intakeDestroy(d->intake);
+    closeSpawnPool();
+    reactorClose();
+    closeDispatcher(d);
+    exit(finished ? EXIT_SUCCESS : EXIT_FAILURE); // a report of the jobs that did finish
+}
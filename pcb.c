@@ -1,8 +1,249 @@
 /* PCB management functions for RR dispatcher */
 
 /* Include Files */
+#include <fcntl.h>
+#include <spawn.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include "pcb.h"
 
+extern char ** environ;
+
+struct launch_stats {
+    long count; // processes launched on this path
+    double total_us; // time spent in startPcb launching them
+    double max_us;
+};
+
+static int simulated = FALSE; // TRUE: no child processes, only Pcb state changes
+static __thread pid_t next_simulated_pid = 1;
+static __thread PoolPtr pcb_pool = NULL; // every Pcb of this thread comes from here
+
+static int launch_mode = LAUNCH_SPAWN; // how startPcb creates new processes
+static pid_t worker_pool[SPAWN_POOL_MAX]; // pre-spawned, stopped ./process workers
+static int worker_count = 0;
+static int worker_target = 0; // size the pool is refilled to
+static struct launch_stats launch_stats[LAUNCH_MODES];
+
+/*******************************************************
+ * void setPcbSimulated(int on) - switch process control
+ *    into (or out of) simulation mode
+ *
+ * In simulation mode startPcb/suspendPcb/terminatePcb do not
+ * fork or signal anything, they only update the Pcb status.
+ ******************************************************/
+void setPcbSimulated(int on)
+{
+    simulated = on;
+}
+
+/*******************************************************
+ * static helpers - process launch paths
+ ******************************************************/
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// posix_spawn ./process with an empty signal mask (the dispatcher blocks SIGCHLD)
+static pid_t spawn_process(char * args[])
+{
+    posix_spawnattr_t attr;
+    sigset_t mask;
+    pid_t pid;
+    int rc;
+
+    sigemptyset(&mask);
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+    fflush(stdout);
+    rc = posix_spawn(&pid, args[0], NULL, &attr, args, environ);
+    posix_spawnattr_destroy(&attr);
+
+    if (rc != 0)
+    {
+        fprintf(stderr, "FATAL: Could not spawn process!\n");
+        exit(EXIT_FAILURE);
+    }
+    return pid;
+}
+
+// fork and exec ./process, the original launch path
+static pid_t fork_process(PcbPtr p)
+{
+    pid_t pid;
+
+    logFlush();
+    switch (pid = fork())
+    {
+        case -1:
+            fprintf(stderr, "FATAL: Could not fork process!\n");
+            exit(EXIT_FAILURE);
+        case 0:
+        {
+            sigset_t mask; // the dispatcher blocks SIGCHLD for its reactor
+            sigemptyset(&mask);
+            sigprocmask(SIG_SETMASK, &mask, NULL);
+            p->pid = getpid();
+            p->status = PCB_RUNNING;
+            logChild();
+            if (logOn(LOG_JOBS))
+            {
+                printPcbHdr();
+                printPcb(p);
+            }
+            fflush(stdout);
+            execv(p->args[0], p->args);
+            fprintf(stderr, "ALERT: You should never see me!\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return pid;
+}
+
+static void record_launch(int mode, double start_us)
+{
+    double us = now_us() - start_us;
+    launch_stats[mode].count++;
+    launch_stats[mode].total_us += us;
+    if (us > launch_stats[mode].max_us)
+        launch_stats[mode].max_us = us;
+}
+
+/*******************************************************
+ * void setPcbLaunch(int mode) - choose how startPcb
+ *    creates new processes: LAUNCH_FORK (fork + execv)
+ *    or LAUNCH_SPAWN (posix_spawn, vfork semantics)
+ *
+ * Pooled workers (see initSpawnPool) are used first
+ * whichever mode is set.
+ ******************************************************/
+void setPcbLaunch(int mode)
+{
+    launch_mode = mode;
+}
+
+/*******************************************************
+ * int initSpawnPool(int size) - keep up to 'size' stopped
+ *    ./process workers ready, so a new job only needs SIGCONT
+ *
+ * returns:
+ *    number of workers in the pool
+ ******************************************************/
+int initSpawnPool(int size)
+{
+    worker_target = size < SPAWN_POOL_MAX ? size : SPAWN_POOL_MAX;
+    refillSpawnPool();
+    return worker_count;
+}
+
+/*******************************************************
+ * void refillSpawnPool() - spawn and stop workers until
+ *    the pool is full again
+ *
+ * Called by the dispatcher just before it blocks, so the
+ * cost stays off the dispatch path.
+ ******************************************************/
+void refillSpawnPool(void)
+{
+    char * args[] = { "./process", NULL };
+
+    while (!simulated && worker_count < worker_target)
+    {
+        int status;
+        pid_t pid = spawn_process(args);
+        kill(pid, SIGSTOP); // uncatchable, the worker has not ticked yet
+        if (waitpid(pid, &status, WUNTRACED) == -1 || !WIFSTOPPED(status))
+        {
+            fprintf(stderr, "ERROR: Could not stop pooled worker %d\n", (int)pid);
+            return;
+        }
+        worker_pool[worker_count++] = pid;
+    }
+}
+
+/*******************************************************
+ * void closeSpawnPool() - kill and reap unused workers
+ ******************************************************/
+void closeSpawnPool(void)
+{
+    worker_target = 0;
+    while (worker_count > 0)
+    {
+        pid_t pid = worker_pool[--worker_count];
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+}
+
+/*******************************************************
+ * void printLaunchStats() - print the time startPcb spent
+ *    launching new processes, for each launch path used
+ *
+ * This is the cost of the call on the dispatch path, not
+ * the time until the job first runs: posix_spawn returns
+ * once the child has exec'd, fork once it is created and a
+ * pooled worker once SIGCONT has been sent.
+ ******************************************************/
+void printLaunchStats(void)
+{
+    static const char * names[LAUNCH_MODES] = { "fork", "spawn", "pool" };
+
+    for (int mode = 0; mode < LAUNCH_MODES; mode++)
+    {
+        if (!launch_stats[mode].count)
+            continue;
+        printf("launch call time (%s): %ld launches, average %.1f us, max %.1f us\n",
+            names[mode], launch_stats[mode].count,
+            launch_stats[mode].total_us / launch_stats[mode].count, launch_stats[mode].max_us);
+    }
+}
+
+/*******************************************************
+ * PoolPtr initPcbPool(int capacity) - create the Pcb pool,
+ *    or grow it, so it holds at least 'capacity' Pcbs
+ *
+ * Every thread has its own pool, so dispatchers in
+ * different threads never share a free list.
+ *
+ * returns:
+ *    PoolPtr of the Pcb pool
+ *    NULL if malloc failed
+ ******************************************************/
+PoolPtr initPcbPool(int capacity)
+{
+    if (!pcb_pool)
+        pcb_pool = poolCreate(sizeof(Pcb), capacity);
+    else if (!poolReserve(pcb_pool, capacity))
+        return NULL;
+    return pcb_pool;
+}
+
+/*******************************************************
+ * void closePcbPool() - release this thread's Pcb pool and
+ *    every Pcb in it
+ ******************************************************/
+void closePcbPool(void)
+{
+    poolDestroy(pcb_pool);
+    pcb_pool = NULL;
+}
+
+/*******************************************************
+ * PoolPtr getPcbPool() - Pcb pool, for its live/peak counters
+ ******************************************************/
+PoolPtr getPcbPool(void)
+{
+    return pcb_pool;
+}
+
 /*******************************************************
  * PcbPtr createnullPcb() - create inactive Pcb.
  *
@@ -13,11 +254,12 @@
 PcbPtr createnullPcb()
 {
     PcbPtr new_process_Ptr;
-    if (!(new_process_Ptr = (PcbPtr)malloc(sizeof(Pcb))))
+    if ((!pcb_pool && !initPcbPool(0)) || !(new_process_Ptr = (PcbPtr)poolAlloc(pcb_pool)))
     {
         fprintf(stderr, "ERROR: Could not create new process control block\n");
         return NULL;
     }
+    new_process_Ptr->id = 0;
     new_process_Ptr->pid = 0;
     new_process_Ptr->args[0] = "./process";
     new_process_Ptr->args[1] = NULL;
@@ -26,11 +268,31 @@ PcbPtr createnullPcb()
     new_process_Ptr->remaining_cpu_time = 0;
     new_process_Ptr->status = PCB_UNINITIALIZED;
     new_process_Ptr->next = NULL;
+    new_process_Ptr->prev = NULL;
+    new_process_Ptr->cpu = -1;
+    new_process_Ptr->first_start_time = -1;
+    new_process_Ptr->preemptions = 0;
+    new_process_Ptr->quantum_left = 0;
+    new_process_Ptr->cpu_used_us = 0;
+    new_process_Ptr->cpu_charged_us = 0;
+    new_process_Ptr->pidfd = -1;
     new_process_Ptr->max_iterations = 0;
     new_process_Ptr->curr_iterations = 0;
+    new_process_Ptr->mem_size = 0;
+    new_process_Ptr->bypass_count = 0;
+    new_process_Ptr->mem_block = NULL;
     return new_process_Ptr;
 }
 
+/*******************************************************
+ * void freePcb(PcbPtr process) - return a Pcb to the pool
+ ******************************************************/
+void freePcb(PcbPtr p)
+{
+    if (p)
+        poolFree(pcb_pool, p);
+}
+
 /*******************************************************
  * PcbPtr enqPcb (PcbPtr headofQ, PcbPtr process)
  *    - queue process (or join queues) at end of queue
@@ -79,6 +341,175 @@ PcbPtr deqPcb(PcbPtr * hPtr)
     }
 }
 
+/*******************************************************
+ * void initPcbQ (PcbQueuePtr queue) - initialise an empty queue
+ ******************************************************/
+void initPcbQ(PcbQueuePtr q)
+{
+    q->head = NULL;
+    q->tail = NULL;
+    q->count = 0;
+}
+
+/*******************************************************
+ * PcbPtr enqPcbQ (PcbQueuePtr queue, PcbPtr process)
+ *    - queue process at end of queue in O(1)
+ *
+ * returns process
+ ******************************************************/
+PcbPtr enqPcbQ(PcbQueuePtr q, PcbPtr p)
+{
+    p->next = NULL;
+    p->prev = q->tail;
+    if (q->tail)
+        q->tail->next = p;
+    else
+        q->head = p;
+    q->tail = p;
+    q->count++;
+    return p;
+}
+
+/*******************************************************
+ * PcbPtr pushPcbQ (PcbQueuePtr queue, PcbPtr process)
+ *    - put process back at head of queue in O(1)
+ *      (used for pre-empted or blocked processes)
+ *
+ * returns process
+ ******************************************************/
+PcbPtr pushPcbQ(PcbQueuePtr q, PcbPtr p)
+{
+    p->next = q->head;
+    p->prev = NULL;
+    if (q->head)
+        q->head->prev = p;
+    q->head = p;
+    if (!q->tail)
+        q->tail = p;
+    q->count++;
+    return p;
+}
+
+/*******************************************************
+ * PcbPtr deqPcbQ (PcbQueuePtr queue)
+ *    - dequeue process - take Pcb from head of queue in O(1)
+ *
+ * returns:
+ *    PcbPtr if dequeued,
+ *    NULL if queue was empty
+ ******************************************************/
+PcbPtr deqPcbQ(PcbQueuePtr q)
+{
+    PcbPtr p = q->head;
+    if (!p)
+        return NULL;
+    q->head = p->next;
+    if (q->head)
+        q->head->prev = NULL;
+    else
+        q->tail = NULL;
+    q->count--;
+    p->next = NULL;
+    return p;
+}
+
+/*******************************************************
+ * PcbPtr popPcbQ (PcbQueuePtr queue)
+ *    - take Pcb from tail of queue in O(1)
+ *      (used by idle CPU slots stealing from a peer)
+ *
+ * returns:
+ *    PcbPtr if removed,
+ *    NULL if queue was empty
+ ******************************************************/
+PcbPtr popPcbQ(PcbQueuePtr q)
+{
+    PcbPtr p = q->tail;
+    if (!p)
+        return NULL;
+    q->tail = p->prev;
+    if (q->tail)
+        q->tail->next = NULL;
+    else
+        q->head = NULL;
+    q->count--;
+    p->prev = NULL;
+    return p;
+}
+
+/*******************************************************
+ * void splicePcbQ (PcbQueuePtr queue, PcbQueuePtr front)
+ *    - move every Pcb of 'front' to the head of 'queue' in O(1),
+ *      keeping their order, and leave 'front' empty
+ ******************************************************/
+void splicePcbQ(PcbQueuePtr q, PcbQueuePtr front)
+{
+    if (!front->head)
+        return;
+    front->tail->next = q->head;
+    if (q->head)
+        q->head->prev = front->tail;
+    q->head = front->head;
+    if (!q->tail)
+        q->tail = front->tail;
+    q->count += front->count;
+    initPcbQ(front);
+}
+
+/*******************************************************
+ * static helpers - /proc and processes taken over by adoptPcb
+ ******************************************************/
+// read /proc/<pid>/<name> into 'buffer', FALSE if it could not be read
+static int read_proc(pid_t pid, const char * name, char * buffer, size_t size)
+{
+    char path[64];
+    ssize_t n;
+    int fd;
+
+    snprintf(path, sizeof(path), "/proc/%d/%s", (int)pid, name);
+    if ((fd = open(path, O_RDONLY)) == -1)
+        return FALSE;
+    n = read(fd, buffer, size - 1);
+    close(fd);
+    if (n <= 0)
+        return FALSE;
+    buffer[n] = '\0';
+    return TRUE;
+}
+
+// state letter of process 'pid' from /proc/<pid>/stat, 'X' if it is gone
+static char proc_state(pid_t pid)
+{
+    char buffer[512];
+    char * fields;
+
+    if (!read_proc(pid, "stat", buffer, sizeof(buffer)) || !(fields = strrchr(buffer, ')')))
+        return 'X';
+    return fields[1] == ' ' ? fields[2] : 'X';
+}
+
+// send 'sig' to the process of 'p', through its pidfd if it was adopted
+static int signal_pcb(PcbPtr p, int sig)
+{
+    if (p->pidfd >= 0)
+        return (int)syscall(SYS_pidfd_send_signal, p->pidfd, sig, NULL, 0);
+    return kill(p->pid, sig);
+}
+
+// stop an adopted process with SIGSTOP and wait (up to a second) until it has
+// stopped: it is not a child, and SIGTSTP is discarded once the process group
+// of the dispatcher that started it is orphaned
+static int stop_adopted(PcbPtr p)
+{
+    struct timespec pause = { 0, 1000000 };
+    char state = 'R';
+
+    signal_pcb(p, SIGSTOP);
+    for (int i = 0; i < 1000 && (state = proc_state(p->pid)) != 'T' && state != 'Z' && state != 'X'; i++)
+        nanosleep(&pause, NULL);
+    return state == 'T';
+}
+
 /*******************************************************
  * PcbPtr startPcb(PcbPtr process) - start (or restart)
  *    a process
@@ -88,27 +519,45 @@ PcbPtr deqPcb(PcbPtr * hPtr)
  ******************************************************/
 PcbPtr startPcb (PcbPtr p)
 {
-    if (p->pid == 0)
+    if (simulated)
     {
-        switch (p->pid = fork())
+        if (p->pid == 0)
         {
-            case -1:
-                fprintf(stderr, "FATAL: Could not fork process!\n");
-                exit(EXIT_FAILURE);
-            case 0:
-                p->pid = getpid();
-                p->status = PCB_RUNNING;
+            p->pid = next_simulated_pid++;
+            p->status = PCB_RUNNING;
+            if (logOn(LOG_JOBS))
+            {
                 printPcbHdr();
                 printPcb(p);
-                fflush(stdout);
-                execv(p->args[0], p->args);
-                fprintf(stderr, "ALERT: You should never see me!\n");
-                exit(EXIT_FAILURE);
+            }
+        }
+    }
+    else if (p->pid == 0)
+    {
+        double start = now_us();
+        int mode = worker_count > 0 ? LAUNCH_POOL : launch_mode;
+
+        if (mode == LAUNCH_POOL)
+        {
+            p->pid = worker_pool[--worker_count];
+            kill(p->pid, SIGCONT);
+        }
+        else if (mode == LAUNCH_SPAWN)
+            p->pid = spawn_process(p->args);
+        else
+            p->pid = fork_process(p);
+        record_launch(mode, start);
+
+        if (mode != LAUNCH_FORK && logOn(LOG_JOBS))
+        {
+            p->status = PCB_RUNNING;
+            printPcbHdr();
+            printPcb(p);
         }
     }
     else
     {
-        kill(p->pid, SIGCONT);
+        signal_pcb(p, SIGCONT);
     }
     p->status = PCB_RUNNING;
     return p;
@@ -133,6 +582,21 @@ PcbPtr suspendPcb(PcbPtr p)
         fprintf(stderr, "ERROR: Process is not running and cannot be suspended\n");
         return NULL;
     }
+    else if (simulated)
+    {
+        p->status = PCB_SUSPENDED;
+        return p;
+    }
+    else if (p->pidfd >= 0)
+    {
+        if (!stop_adopted(p))
+        {
+            fprintf(stderr, "ERROR: Failed to stop process %d\n", (int)p->pid);
+            return NULL;
+        }
+        p->status = PCB_SUSPENDED;
+        return p;
+    }
     else
     {
         kill(p->pid, SIGTSTP); // Suspend the process with SIGTSTP
@@ -161,55 +625,201 @@ PcbPtr terminatePcb(PcbPtr p)
         fprintf(stderr, "ERROR: Cannot terminate a NULL process\n");
         return NULL;
     }
+    else if (simulated)
+    {
+        p->status = PCB_TERMINATED;
+        return p;
+    }
+    else if (p->pidfd >= 0)
+    {
+        // not a child: no wait4, its CPU time is the last sample before it ends
+        struct pollfd exited = { p->pidfd, POLLIN, 0 };
+        samplePcbCpu(p);
+        signal_pcb(p, SIGINT);
+        while (poll(&exited, 1, -1) == -1)
+            ; // EINTR
+        close(p->pidfd);
+        p->pidfd = -1;
+        p->status = PCB_TERMINATED;
+        return p;
+    }
     else
     {
         kill(p->pid, SIGINT); // Terminate the process with SIGINT
         int status;
-        if (waitpid(p->pid, &status, 0) == -1)
+        struct rusage usage; // what the process consumed over its whole life
+        if (wait4(p->pid, &status, 0, &usage) == -1)
         {
             fprintf(stderr, "ERROR: Failed to wait for process termination\n");
             return NULL;
         }
+        p->cpu_used_us = (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000L
+            + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
         p->status = PCB_TERMINATED;
         return p;
     }
 }
 
 
+/*******************************************************
+ * long samplePcbCpu(PcbPtr process) - sample the CPU time
+ *    a running or stopped process has consumed so far
+ *
+ * Reads the scheduler's nanosecond run time from
+ * /proc/<pid>/schedstat, or utime + stime in clock ticks
+ * from /proc/<pid>/stat on kernels without schedstats.
+ * terminatePcb replaces it with the total from wait4.
+ *
+ * returns:
+ *    p->cpu_used_us, updated unless the process could not
+ *    be sampled (or is simulated)
+ ******************************************************/
+long samplePcbCpu(PcbPtr p)
+{
+    char buffer[512];
+    unsigned long long run_ns;
+    unsigned long utime, stime;
+    long used = -1;
+
+    if (simulated || p->pid <= 0)
+        return p->cpu_used_us;
+    if (read_proc(p->pid, "schedstat", buffer, sizeof(buffer))
+        && sscanf(buffer, "%llu", &run_ns) == 1)
+        used = (long)(run_ns / 1000);
+    else if (read_proc(p->pid, "stat", buffer, sizeof(buffer)))
+    {
+        // fields 14 and 15, counted after the ")" that ends the command name
+        char * fields = strrchr(buffer, ')');
+        if (fields && sscanf(fields + 1, " %*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+            &utime, &stime) == 2)
+            used = (long)((utime + stime) * (1000000.0 / sysconf(_SC_CLK_TCK)));
+    }
+    if (used > p->cpu_used_us)
+        p->cpu_used_us = used;
+    return p->cpu_used_us;
+}
+
+/*******************************************************
+ * int adoptPcb(PcbPtr process, unsigned long long start_time)
+ *    - take over the process an earlier dispatcher started
+ *    for 'process' (see checkpoint.c), if it still runs
+ *
+ * Parameters:
+ *   start_time - pcbStartTime of the process when the
+ *                snapshot was taken, so that a later process
+ *                given the same pid is not mistaken for it.
+ *
+ * The process is held through a pidfd from then on, and
+ * is continued or stopped to match p->status. It is not a
+ * child: reactorWait does not see it exit before its
+ * quantum ends, and terminatePcb waits on the pidfd.
+ *
+ * returns:
+ *    TRUE if the process was taken over (always when simulated)
+ *    FALSE and p->pid set to 0 if it is gone, so that
+ *    startPcb starts it afresh
+ ******************************************************/
+int adoptPcb(PcbPtr p, unsigned long long start_time)
+{
+    int fd = -1;
+
+    if (simulated)
+        return TRUE;
+    if (p->pid <= 0 || !start_time || pcbStartTime(p->pid) != start_time
+        || (fd = (int)syscall(SYS_pidfd_open, p->pid, 0)) == -1
+        || pcbStartTime(p->pid) != start_time) // the pidfd pins the pid, look again
+    {
+        if (fd != -1)
+            close(fd);
+        p->pid = 0;
+        return FALSE;
+    }
+    p->pidfd = fd;
+    if (p->status == PCB_RUNNING)
+        signal_pcb(p, SIGCONT);
+    else
+        stop_adopted(p);
+    return TRUE;
+}
+
+/*******************************************************
+ * unsigned long long pcbStartTime(pid_t pid) - clock ticks
+ *    after boot that process 'pid' started at (field 22 of
+ *    /proc/<pid>/stat)
+ *
+ * Only uses async-signal-safe calls, so the snapshot
+ * writer can call it in a forked child.
+ *
+ * returns:
+ *    the start time, 0 if there is no such process
+ ******************************************************/
+unsigned long long pcbStartTime(pid_t pid)
+{
+    char path[32] = "/proc/", digits[16], buffer[512];
+    unsigned long long start = 0;
+    int n = 0, len = 6, fd, spaces = 0;
+    ssize_t got;
+    char * c;
+
+    do
+        digits[n++] = '0' + pid % 10;
+    while ((pid /= 10) > 0);
+    while (n)
+        path[len++] = digits[--n];
+    memcpy(path + len, "/stat", 6);
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1)
+        return 0;
+    got = read(fd, buffer, sizeof(buffer) - 1);
+    close(fd);
+    if (got <= 0)
+        return 0;
+    buffer[got] = '\0';
+
+    // fields are counted after the ")" that ends the command name, field 22 follows the 20th space
+    if (!(c = strrchr(buffer, ')')))
+        return 0;
+    for (; *c && spaces < 20; c++)
+        spaces += *c == ' ';
+    for (; *c >= '0' && *c <= '9'; c++)
+        start = start * 10 + (*c - '0');
+    return start;
+}
+
 /*******************************************************
  * PcbPtr printPcb(PcbPtr process)
- *  - print process attributes on stdout
+ *  - print process attributes to the log (see logger.h)
  *  returns:
  *    PcbPtr of process
  ******************************************************/
 PcbPtr printPcb(PcbPtr p)
 {
-    printf("%7d%7d%7d%7d  ",
-        (int) p->pid, p->arrival_time, p->service_time,
-            p->remaining_cpu_time);
+    const char * status;
     switch (p->status) {
         case PCB_UNINITIALIZED:
-            printf("UNINITIALIZED");
+            status = "UNINITIALIZED";
             break;
         case PCB_INITIALIZED:
-            printf("INITIALIZED");
+            status = "INITIALIZED";
             break;
         case PCB_READY:
-            printf("READY");
+            status = "READY";
             break;
         case PCB_RUNNING:
-            printf("RUNNING");
+            status = "RUNNING";
             break;
         case PCB_SUSPENDED:
-            printf("SUSPENDED");
+            status = "SUSPENDED";
             break;
         case PCB_TERMINATED:
-            printf("PCB_TERMINATED");
+            status = "PCB_TERMINATED";
             break;
         default:
-            printf("UNKNOWN");
+            status = "UNKNOWN";
     }
-    printf("\n");
+    logPrintf("%7d%7d%7d%7d  %s\n",
+        (int) p->pid, p->arrival_time, p->service_time,
+            p->remaining_cpu_time, status);
     
     return p;     
 }
@@ -221,6 +831,6 @@ PcbPtr printPcb(PcbPtr p)
  ******************************************************/
 void printPcbHdr()
 {  
-    printf("    pid arrive  prior    cpu  status\n");
+    logPrintf("    pid arrive  prior    cpu  status\n");
 
 }
@@ -6,10 +6,13 @@
 /* Include files */
 #include <stdio.h>
 #include <stdlib.h>
+#include <limits.h>
 #include <signal.h>
 #include <sys/wait.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include "pool.h"
+#include "logger.h"
 
 #ifndef FALSE
 #define FALSE 0
@@ -27,12 +30,24 @@
 #define PCB_SUSPENDED 4
 #define PCB_TERMINATED 5
 
+#define LEVELS 3 // Level-0, Level-1 and Level-2 queues
+#define PCB_TIME_MAX (INT_MAX - 1) // latest time a job may arrive or end by, in time
+                                   // units (INT_MAX is the timer wheel's "none armed")
+
+/* Process Launch Definitions *********************************/
+#define LAUNCH_FORK 0 // fork + execv
+#define LAUNCH_SPAWN 1 // posix_spawn
+#define LAUNCH_POOL 2 // SIGCONT to a pre-spawned, stopped worker
+#define LAUNCH_MODES 3
+#define SPAWN_POOL_MAX 64
+
 // megabytes
-#define MEM_LIMIT = 2048 
-#define BLOCK_MIN_SIZE = 8
+#define MEM_LIMIT 2048
+#define BLOCK_MIN_SIZE 8
 
 /* Custom Data Types */
 struct pcb {
+    int id; // position in the job list
     pid_t pid;
     char * args[3];
     int arrival_time;
@@ -42,22 +57,60 @@ struct pcb {
     int status;
     int max_iterations;
     int curr_iterations;
-    struct mab * mem_block;
+    int mem_size; // megabytes requested by the job
+    int bypass_count; // later jobs admitted while this one was blocked
+    struct mab * mem_block; // allocated block, NULL until admitted
+    int cpu; // CPU slot the job last ran on, -1 if it never ran
+    int first_start_time; // first dispatch, -1 until then
+    int preemptions; // times suspended before it finished
+    int quantum_left; // rest of a Level-1 quantum cut short by a Level-0 job, 0 if none
+    long cpu_used_us; // CPU time the process consumed, as last sampled (real time only)
+    long cpu_charged_us; // ... of which the dispatcher has charged (ACCOUNT_CPU)
+    int pidfd; // -1, or a pidfd of a process taken over from an earlier dispatcher (adoptPcb)
     struct pcb * next;
+    struct pcb * prev; // only maintained by the PcbQueue functions
 };
 
 typedef struct pcb Pcb;
 typedef Pcb * PcbPtr;
 
+struct pcb_queue {
+    PcbPtr head; // next Pcb to be dequeued
+    PcbPtr tail; // last Pcb enqueued, for O(1) enqueue and steal
+    int count; // number of Pcbs in the queue
+};
+
+typedef struct pcb_queue PcbQueue;
+typedef PcbQueue * PcbQueuePtr;
+
 /* Function Prototypes */
+void   setPcbSimulated(int);
+void   setPcbLaunch(int);
+int    initSpawnPool(int);
+void   refillSpawnPool(void);
+void   closeSpawnPool(void);
+void   printLaunchStats(void);
 PcbPtr startPcb(PcbPtr);
 PcbPtr suspendPcb(PcbPtr);
 PcbPtr terminatePcb(PcbPtr);
+long   samplePcbCpu(PcbPtr);
+int    adoptPcb(PcbPtr, unsigned long long start_time);
+unsigned long long pcbStartTime(pid_t); // /proc/<pid>/stat starttime, 0 if there is no such process
 PcbPtr printPcb(PcbPtr);
 void   printPcbHdr(void);
+PoolPtr initPcbPool(int);
+PoolPtr getPcbPool(void);
+void   closePcbPool(void);
 PcbPtr createnullPcb();
+void   freePcb(PcbPtr);
 PcbPtr enqPcb(PcbPtr, PcbPtr);
 PcbPtr deqPcb(PcbPtr*);
+void   initPcbQ(PcbQueuePtr);
+PcbPtr enqPcbQ(PcbQueuePtr, PcbPtr);
+PcbPtr pushPcbQ(PcbQueuePtr, PcbPtr);
+PcbPtr deqPcbQ(PcbQueuePtr);
+PcbPtr popPcbQ(PcbQueuePtr);
+void   splicePcbQ(PcbQueuePtr, PcbQueuePtr);
 
 #endif
 
@@ -0,0 +1,139 @@
+/* Fixed-size object pool for MLQD dispatcher Pcb and Mab nodes */
+
+/* Include Files */
+#include <stddef.h>
+#include "pool.h"
+
+#define POOL_ALIGN sizeof(max_align_t)
+#define POOL_ROUND(n) (((n) + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN)
+
+/*******************************************************
+ * static int pool_grow(PoolPtr p, int n) - add a chunk of
+ *    'n' objects to the free list
+ *
+ * returns: TRUE on success, FALSE if malloc failed
+ ******************************************************/
+static int pool_grow(PoolPtr p, int n)
+{
+    struct pool_chunk * c = (struct pool_chunk *)malloc(
+            POOL_ROUND(sizeof(struct pool_chunk)) + (size_t)n * p->obj_size);
+    if (!c)
+        return FALSE;
+
+    c->next = p->chunks;
+    p->chunks = c;
+    p->chunk_count++;
+    p->capacity += n;
+
+    // thread the new objects onto the free list, first object first
+    char * obj = (char *)c + POOL_ROUND(sizeof(struct pool_chunk));
+    for (int i = n - 1; i >= 0; i--)
+    {
+        void ** link = (void **)(obj + (size_t)i * p->obj_size);
+        *link = p->free_list;
+        p->free_list = link;
+    }
+    return TRUE;
+}
+
+/*******************************************************
+ * PoolPtr poolCreate(size_t obj_size, int capacity)
+ *    - create a pool of fixed-size objects
+ *
+ * Parameters:
+ *   obj_size - size of each object.
+ *   capacity - objects to preallocate; the pool doubles
+ *              when it runs out.
+ *
+ * returns:
+ *    PoolPtr of the new pool
+ *    NULL if malloc failed
+ ******************************************************/
+PoolPtr poolCreate(size_t obj_size, int capacity)
+{
+    PoolPtr p = (PoolPtr)calloc(1, sizeof(Pool));
+    if (!p)
+    {
+        fprintf(stderr, "ERROR: Could not create object pool\n");
+        return NULL;
+    }
+
+    if (obj_size < sizeof(void *))
+        obj_size = sizeof(void *);
+    p->obj_size = POOL_ROUND(obj_size);
+    p->chunk_objs = capacity > 0 ? capacity : 64;
+
+    if (capacity > 0 && !pool_grow(p, capacity))
+    {
+        fprintf(stderr, "ERROR: Could not create object pool\n");
+        free(p);
+        return NULL;
+    }
+    return p;
+}
+
+/*******************************************************
+ * int poolReserve(PoolPtr p, int capacity) - make sure
+ *    the pool holds at least 'capacity' objects
+ *
+ * returns: TRUE on success, FALSE if malloc failed
+ ******************************************************/
+int poolReserve(PoolPtr p, int capacity)
+{
+    if (capacity <= p->capacity)
+        return TRUE;
+    return pool_grow(p, capacity - p->capacity);
+}
+
+/*******************************************************
+ * void * poolAlloc(PoolPtr p) - take an object from the pool
+ *
+ * returns:
+ *    pointer to an uninitialised object
+ *    NULL if the pool was empty and malloc failed
+ ******************************************************/
+void * poolAlloc(PoolPtr p)
+{
+    if (!p->free_list)
+    {
+        if (!pool_grow(p, p->chunk_objs))
+            return NULL;
+        p->chunk_objs *= 2; // keep the number of heap calls logarithmic
+    }
+
+    void ** obj = (void **)p->free_list;
+    p->free_list = *obj;
+    if (++p->live > p->peak)
+        p->peak = p->live;
+    return obj;
+}
+
+/*******************************************************
+ * void poolFree(PoolPtr p, void * obj) - give an object
+ *    back to the pool for reuse
+ ******************************************************/
+void poolFree(PoolPtr p, void * obj)
+{
+    if (!obj)
+        return;
+    *(void **)obj = p->free_list;
+    p->free_list = obj;
+    p->live--;
+}
+
+/*******************************************************
+ * void poolDestroy(PoolPtr p) - release every chunk of
+ *    the pool, including objects still handed out
+ ******************************************************/
+void poolDestroy(PoolPtr p)
+{
+    if (!p)
+        return;
+    while (p->chunks)
+    {
+        struct pool_chunk * c = p->chunks;
+        p->chunks = c->next;
+        free(c);
+    }
+    free(p);
+}
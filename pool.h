@@ -0,0 +1,44 @@
+/* Object pool include header file for MLQD dispatcher */
+
+#ifndef MLQD_POOL
+#define MLQD_POOL
+
+/* Include files */
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+/* Custom Data Types */
+struct pool_chunk {
+    struct pool_chunk * next; // chunks are only released by poolDestroy
+};
+
+struct pool {
+    size_t obj_size; // size of one object, rounded up for alignment
+    int chunk_objs; // objects in the next chunk to be allocated
+    void * free_list; // released objects, linked through their first word
+    struct pool_chunk * chunks; // every chunk obtained from malloc
+    int live; // objects currently handed out
+    int peak; // highest value 'live' has reached
+    int capacity; // objects in all chunks
+    int chunk_count; // number of chunks (heap calls) so far
+};
+
+typedef struct pool Pool;
+typedef Pool * PoolPtr;
+
+/* Function Prototypes */
+PoolPtr poolCreate(size_t obj_size, int capacity); // create a pool, preallocating 'capacity' objects
+int     poolReserve(PoolPtr p, int capacity); // grow the pool to hold at least 'capacity' objects
+void *  poolAlloc(PoolPtr p); // take an object from the pool
+void    poolFree(PoolPtr p, void * obj); // give an object back to the pool
+void    poolDestroy(PoolPtr p); // release the pool and every object in it
+
+#endif
@@ -0,0 +1,240 @@
+/* Event reactor for MLQD dispatcher
+
+   The real-time dispatcher sleeps in epoll_wait on up to three descriptors:
+     - a timerfd armed with the absolute CLOCK_MONOTONIC deadline of the
+       next scheduling event (quantum end, arrival), in the chosen time unit
+     - a signalfd receiving SIGCHLD, so a child that exits early wakes
+       the dispatcher straight away instead of at the next deadline,
+       and SIGUSR1, which asks for a snapshot of the dispatcher state
+     - optionally an eventfd (reactorWatch), signalled when jobs are
+       submitted while the dispatcher runs
+*/
+
+/* Include Files */
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include "reactor.h"
+
+static int epoll_fd = -1;
+static int timer_fd = -1;
+static int signal_fd = -1;
+static int watch_fd = -1;
+static struct timespec epoch; // dispatcher time 0
+
+/*******************************************************
+ * int reactorInit() - create the reactor descriptors and
+ *    start its clock
+ *
+ * SIGCHLD and SIGUSR1 are blocked so that they are only
+ * delivered through the signalfd; startPcb unblocks them
+ * again in children.
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int reactorInit(void)
+{
+    sigset_t mask;
+    struct epoll_event ev;
+
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGUSR1);
+    if (sigprocmask(SIG_BLOCK, &mask, NULL) == -1
+        || (signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC)) == -1
+        || (timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == -1
+        || (epoll_fd = epoll_create1(EPOLL_CLOEXEC)) == -1)
+    {
+        perror("ERROR: Could not create dispatcher reactor");
+        return FALSE;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = timer_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, timer_fd, &ev) == -1)
+    {
+        perror("ERROR: Could not create dispatcher reactor");
+        return FALSE;
+    }
+    ev.data.fd = signal_fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, signal_fd, &ev) == -1)
+    {
+        perror("ERROR: Could not create dispatcher reactor");
+        return FALSE;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &epoch);
+    return TRUE;
+}
+
+/*******************************************************
+ * double reactorElapsed() - seconds of real time since
+ *    reactorInit
+ ******************************************************/
+double reactorElapsed(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - epoch.tv_sec) + (now.tv_nsec - epoch.tv_nsec) / 1e9;
+}
+
+/*******************************************************
+ * void reactorSetElapsed(double seconds) - move the start
+ *    of the clock so that reactorElapsed returns 'seconds'
+ *    now: a restored dispatcher carries on from the time
+ *    of its snapshot
+ ******************************************************/
+void reactorSetElapsed(double seconds)
+{
+    long long ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &epoch);
+    ns = epoch.tv_sec * 1000000000LL + epoch.tv_nsec - (long long)(seconds * 1e9);
+    epoch.tv_sec = ns / 1000000000LL;
+    epoch.tv_nsec = ns % 1000000000LL;
+    if (epoch.tv_nsec < 0) // before boot, for a snapshot taken late in a long run
+    {
+        epoch.tv_sec--;
+        epoch.tv_nsec += 1000000000LL;
+    }
+}
+
+/*******************************************************
+ * int reactorExited(pid_t pid) - TRUE if child 'pid' has
+ *    exited; the zombie is left for terminatePcb to reap
+ ******************************************************/
+int reactorExited(pid_t pid)
+{
+    siginfo_t info;
+    if (pid <= 0)
+        return FALSE;
+    memset(&info, 0, sizeof(info));
+    if (waitid(P_PID, pid, &info, WEXITED | WNOHANG | WNOWAIT) == -1)
+        return FALSE;
+    return info.si_pid == pid;
+}
+
+// TRUE if any of the 'count' children in 'pids' has exited
+static int any_exited(pid_t * pids, int count)
+{
+    for (int i = 0; i < count; i++)
+        if (reactorExited(pids[i]))
+            return TRUE;
+    return FALSE;
+}
+
+/*******************************************************
+ * int reactorWatch(int fd) - make reactorWait return
+ *    early when eventfd 'fd' is signalled; the reactor
+ *    resets its counter
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int reactorWatch(int fd)
+{
+    struct epoll_event ev;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) == -1)
+    {
+        perror("ERROR: Could not watch the job intake");
+        return FALSE;
+    }
+    watch_fd = fd;
+    return TRUE;
+}
+
+/*******************************************************
+ * int reactorWait(double deadline, pid_t * pids, int count)
+ *    - block until 'deadline' (seconds since reactorInit),
+ *    until one of the watched children exits or until the
+ *    reactorWatch eventfd is signalled, whichever comes first
+ *
+ * Parameters:
+ *   deadline - absolute dispatcher time to wake up at, none if < 0.
+ *   pids - children to watch, entries of 0 are ignored.
+ *   count - number of entries in 'pids'.
+ *
+ * returns:
+ *    REACTOR_TIMEOUT if the deadline was reached
+ *    REACTOR_CHILD_EXIT if a watched child exited first
+ *    REACTOR_WAKE if the eventfd was signalled first
+ *    REACTOR_USER_SIGNAL if SIGUSR1 was received first
+ ******************************************************/
+int reactorWait(double deadline, pid_t * pids, int count)
+{
+    struct itimerspec its;
+    struct epoll_event ev;
+    long long ns = epoch.tv_nsec + (long long)(deadline * 1e9);
+
+    if (any_exited(pids, count))
+        return REACTOR_CHILD_EXIT;
+
+    memset(&its, 0, sizeof(its)); // all zero disarms the timer
+    if (deadline >= 0)
+    {
+        its.it_value.tv_sec = epoch.tv_sec + ns / 1000000000LL;
+        its.it_value.tv_nsec = ns % 1000000000LL;
+    }
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &its, NULL) == -1)
+    {
+        perror("FATAL: Could not arm dispatcher timer");
+        exit(EXIT_FAILURE);
+    }
+
+    while (1)
+    {
+        int n = epoll_wait(epoll_fd, &ev, 1, -1);
+        if (n == -1)
+            continue; // EINTR
+
+        if (ev.data.fd == signal_fd)
+        {
+            struct signalfd_siginfo si;
+            int user = FALSE;
+            while (read(signal_fd, &si, sizeof(si)) == sizeof(si))
+                user |= si.ssi_signo == SIGUSR1; // drain, SIGCHLD is also raised for stops and continues
+            if (user)
+                return REACTOR_USER_SIGNAL; // the caller looks for exited children as after any wake-up
+            if (any_exited(pids, count))
+                return REACTOR_CHILD_EXIT;
+        }
+        else if (ev.data.fd == watch_fd)
+        {
+            uint64_t signalled;
+            if (read(watch_fd, &signalled, sizeof(signalled)) == sizeof(signalled))
+                return REACTOR_WAKE;
+        }
+        else
+        {
+            unsigned long long expirations;
+            if (read(timer_fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+                return REACTOR_TIMEOUT;
+        }
+    }
+}
+
+/*******************************************************
+ * void reactorClose() - release the reactor descriptors
+ ******************************************************/
+void reactorClose(void)
+{
+    if (epoll_fd != -1)
+        close(epoll_fd);
+    if (timer_fd != -1)
+        close(timer_fd);
+    if (signal_fd != -1)
+        close(signal_fd);
+    epoll_fd = timer_fd = signal_fd = watch_fd = -1;
+}
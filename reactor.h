@@ -0,0 +1,36 @@
+/* Event reactor include header file for MLQD dispatcher */
+
+#ifndef MLQD_REACTOR
+#define MLQD_REACTOR
+
+/* Include files */
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+/* reactorWait results */
+#define REACTOR_TIMEOUT 0 // the deadline was reached
+#define REACTOR_CHILD_EXIT 1 // a watched child exited before the deadline
+#define REACTOR_WAKE 2 // the descriptor given to reactorWatch became readable
+#define REACTOR_USER_SIGNAL 3 // SIGUSR1 was received (a snapshot is asked for, see checkpoint.h)
+
+/* Function Prototypes */
+int    reactorInit(void); // set up epoll, timerfd and signalfd(SIGCHLD, SIGUSR1)
+int    reactorWatch(int fd); // also wake up when eventfd 'fd' is signalled
+int    reactorWait(double deadline, pid_t * pids, int count); // block until 'deadline' or a child in 'pids' exits
+int    reactorExited(pid_t pid); // TRUE if child 'pid' has exited, without reaping it
+double reactorElapsed(void); // seconds since reactorInit
+void   reactorSetElapsed(double seconds); // resume the clock at 'seconds', after a restore
+void   reactorClose(void);
+
+#endif
@@ -0,0 +1,214 @@
+/* Parameter sweep for MLQD dispatcher
+
+   Runs one simulated dispatcher per (t0, t1, k) point. Workers claim
+   points with an atomic add and keep everything they touch to
+   themselves: their own Dispatcher, memory heap and (thread-local)
+   Pcb pool. The only shared state is the read-only job records and
+   each worker's own slot in the results.
+*/
+
+/* Include Files */
+#include <pthread.h>
+#include <string.h>
+#include "sweep.h"
+
+/*******************************************************
+ * static helpers - in calling order
+ ******************************************************/
+
+// 1. run_point - simulate one point and summarise it into 'pt'
+static void run_point(SweepPtr s, SweepPointPtr pt)
+{
+    Dispatcher d;
+
+    if (!initPcbPool(s->jobs) || !initDispatcher(&d, s->cpus, s->layout, s->mem_policy))
+        exit(EXIT_FAILURE);
+    d.simulate = TRUE;
+    d.max_bypass = s->max_bypass;
+    d.t0 = pt->t0;
+    d.t1 = pt->t1;
+    d.k = pt->k;
+
+    for (int i = 0; i < s->jobs; i++)
+        if (!enqJobRecord(&d.job_queue, &s->records[i], i))
+            exit(EXIT_FAILURE);
+
+    pt->ok = runDispatcher(&d);
+    pt->runtime = d.timer;
+
+    LatencyHistPtr t = &d.metrics.all[METRIC_TURNAROUND];
+    LatencyHistPtr w = &d.metrics.all[METRIC_WAIT];
+    pt->turnaround_mean = t->count ? t->sum / t->count : 0.0;
+    pt->turnaround_p50 = percentileHist(t, 50);
+    pt->turnaround_p90 = percentileHist(t, 90);
+    pt->turnaround_p99 = percentileHist(t, 99);
+    pt->turnaround_max = t->max;
+    pt->wait_mean = w->count ? w->sum / w->count : 0.0;
+    pt->wait_p50 = percentileHist(w, 50);
+    pt->wait_p90 = percentileHist(w, 90);
+    pt->wait_p99 = percentileHist(w, 99);
+    pt->wait_max = w->max;
+
+    closeDispatcher(&d);
+    closePcbPool(); // also drops the Pcbs a deadlocked run left behind
+}
+
+// 2. sweep_worker - run points until none are left
+static void * sweep_worker(void * arg)
+{
+    SweepPtr s = (SweepPtr)arg;
+    int i;
+
+    while ((i = __atomic_fetch_add(&s->next, 1, __ATOMIC_RELAXED)) < s->count)
+        run_point(s, &s->points[i]);
+    return NULL;
+}
+
+/*******************************************************
+ * int parseSweepList(const char * list, int * values,
+ *    int max) - parse a list of positive integers: single
+ *    values and ranges, comma separated, e.g. "1,2,4",
+ *    "1-8" or "2-16:2" (every second value from 2 to 16)
+ *
+ * returns:
+ *    number of values written to 'values'
+ *    -1 if the list is malformed, not positive or longer
+ *    than 'max' (reported on stderr)
+ ******************************************************/
+int parseSweepList(const char * list, int * values, int max)
+{
+    const char * c = list;
+    int n = 0;
+
+    while (1)
+    {
+        char * end;
+        long first = strtol(c, &end, 10), last = first, step = 1;
+
+        if (end == c)
+            break;
+        if (*end == '-')
+        {
+            c = end + 1;
+            last = strtol(c, &end, 10);
+            if (end == c)
+                break;
+            if (*end == ':')
+            {
+                c = end + 1;
+                step = strtol(c, &end, 10);
+                if (end == c)
+                    break;
+            }
+        }
+        if (first <= 0 || last < first || step <= 0 || last > 1000000000L)
+            break;
+        for (long v = first; v <= last; v += step)
+        {
+            if (n == max)
+            {
+                fprintf(stderr, "ERROR: \"%s\" has more than %d values\n", list, max);
+                return -1;
+            }
+            values[n++] = (int)v;
+        }
+        if (*end == '\0')
+            return n;
+        if (*end != ',')
+            break;
+        c = end + 1;
+    }
+    fprintf(stderr, "ERROR: \"%s\" is not a list of positive integers or ranges\n", list);
+    return -1;
+}
+
+/*******************************************************
+ * int loadSweepJobs(SweepPtr s, PcbQueuePtr queue) -
+ *    copy the jobs of a loaded job list into s->records
+ *    and free their Pcbs, emptying 'queue'
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE if the records could not be allocated
+ ******************************************************/
+int loadSweepJobs(SweepPtr s, PcbQueuePtr queue)
+{
+    PcbPtr p;
+
+    s->jobs = 0;
+    if (!(s->records = (JobRecord *)malloc((size_t)queue->count * sizeof(JobRecord) + 1)))
+    {
+        fprintf(stderr, "ERROR: Could not allocate job records\n");
+        return FALSE;
+    }
+    while ((p = deqPcbQ(queue)))
+    {
+        s->records[s->jobs].arrival_time = p->arrival_time;
+        s->records[s->jobs].service_time = p->service_time;
+        s->records[s->jobs].mem_size = p->mem_size;
+        s->jobs++;
+        freePcb(p);
+    }
+    return TRUE;
+}
+
+/*******************************************************
+ * int runSweep(SweepPtr s, int threads) - simulate every
+ *    point of s->points, spread over 'threads' workers
+ *    (fewer if there are fewer points)
+ *
+ * returns:
+ *    TRUE when every point has been run
+ *    FALSE if no worker could be started
+ ******************************************************/
+int runSweep(SweepPtr s, int threads)
+{
+    pthread_t workers[SWEEP_THREADS_MAX];
+    int started = 0;
+
+    if (threads > s->count)
+        threads = s->count;
+    if (threads > SWEEP_THREADS_MAX)
+        threads = SWEEP_THREADS_MAX;
+
+    setPcbSimulated(TRUE);
+    logSetLevel(LOG_QUIET);
+    s->next = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        if (pthread_create(&workers[i], NULL, sweep_worker, s) != 0)
+            break;
+        started++;
+    }
+    if (!started)
+    {
+        fprintf(stderr, "ERROR: Could not start sweep workers\n");
+        return FALSE;
+    }
+    for (int i = 0; i < started; i++)
+        pthread_join(workers[i], NULL);
+    return TRUE;
+}
+
+/*******************************************************
+ * void printSweep(SweepPtr s) - print one row per point:
+ *    total runtime, then turnaround and wait time as
+ *    mean/p50/p90/p99/max (percentiles within 12.5%)
+ ******************************************************/
+void printSweep(SweepPtr s)
+{
+    printf("%5s %5s %5s %8s | %10s %8s %8s %8s %8s | %10s %8s %8s %8s %8s\n",
+        "t0", "t1", "k", "runtime",
+        "turn mean", "p50", "p90", "p99", "max",
+        "wait mean", "p50", "p90", "p99", "max");
+    for (int i = 0; i < s->count; i++)
+    {
+        SweepPointPtr pt = &s->points[i];
+        printf("%5d %5d %5d %8d | %10.3f %8ld %8ld %8ld %8ld | %10.3f %8ld %8ld %8ld %8ld%s\n",
+            pt->t0, pt->t1, pt->k, pt->runtime,
+            pt->turnaround_mean, pt->turnaround_p50, pt->turnaround_p90,
+            pt->turnaround_p99, pt->turnaround_max,
+            pt->wait_mean, pt->wait_p50, pt->wait_p90, pt->wait_p99, pt->wait_max,
+            pt->ok ? "" : "  (deadlock)");
+    }
+}
@@ -0,0 +1,47 @@
+/* Parameter sweep include header file for MLQD dispatcher */
+
+#ifndef MLQD_SWEEP
+#define MLQD_SWEEP
+
+/* Include files */
+#include "dispatcher.h"
+#include "jobfile.h"
+
+/* Sweep Definitions ******************************************/
+#define SWEEP_VALUES_MAX 4096 // values in one --t0/--t1/--k list
+#define SWEEP_POINTS_MAX (1 << 20) // t0 x t1 x k combinations
+#define SWEEP_THREADS_MAX 1024
+
+/* Custom Data Types */
+struct sweep_point {
+    int t0, t1, k;
+    int ok; // FALSE if jobs were left that could never be allocated memory
+    int runtime; // dispatcher time the last job finished at
+    double turnaround_mean, wait_mean;
+    long turnaround_p50, turnaround_p90, turnaround_p99, turnaround_max;
+    long wait_p50, wait_p90, wait_p99, wait_max;
+};
+
+typedef struct sweep_point SweepPoint;
+typedef SweepPoint * SweepPointPtr;
+
+/* One simulation per point, every worker reads the same job records */
+struct sweep {
+    JobRecord * records; // shared, read-only while the sweep runs
+    int jobs;
+    int cpus, layout, mem_policy, max_bypass; // as for initDispatcher / --max-bypass
+    SweepPointPtr points;
+    int count;
+    int next; // next point to run, claimed with an atomic add
+};
+
+typedef struct sweep Sweep;
+typedef Sweep * SweepPtr;
+
+/* Function Prototypes */
+int    parseSweepList(const char * list, int * values, int max); // "2", "1,2,4", "1-8" or "2-16:2"
+int    loadSweepJobs(SweepPtr s, PcbQueuePtr queue); // move a loaded job list into s->records
+int    runSweep(SweepPtr s, int threads); // simulate every point on 'threads' workers
+void   printSweep(SweepPtr s); // one table row per point on stdout
+
+#endif
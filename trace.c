@@ -0,0 +1,114 @@
+/* Scheduling trace ring for MLQD dispatcher
+
+   Events are written into a preallocated ring by traceEvent (trace.h)
+   while the dispatcher runs and only copied out by traceWrite at exit,
+   so recording never allocates, blocks or does I/O. See traceconv for
+   turning a trace into Chrome trace JSON.
+*/
+
+/* Include Files */
+#include <string.h>
+#include "trace.h"
+
+TraceRing * trace_ring = NULL;
+
+/*******************************************************
+ * int traceInit(int capacity, uint32_t tick_us) - start
+ *    tracing into a ring of 'capacity' events, rounded up
+ *    to a power of two; dispatcher time is in units of
+ *    'tick_us' microseconds
+ *
+ * The ring is touched up front so that recording does
+ * not take page faults.
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int traceInit(int capacity, uint32_t tick_us)
+{
+    TraceRing * r = (TraceRing *)calloc(1, sizeof(TraceRing));
+    uint64_t size = 1;
+
+    while (size < (uint64_t)capacity)
+        size <<= 1;
+    if (!r || !(r->events = (TraceEvent *)malloc(size * sizeof(TraceEvent))))
+    {
+        fprintf(stderr, "ERROR: Could not allocate a trace of %d events\n", capacity);
+        free(r);
+        return FALSE;
+    }
+    memset(r->events, 0, size * sizeof(TraceEvent));
+    r->capacity = size;
+    r->tick_us = tick_us;
+    clock_gettime(CLOCK_MONOTONIC, &r->epoch);
+    trace_ring = r;
+    return TRUE;
+}
+
+/*******************************************************
+ * int traceWrite(char * path) - write the traced events,
+ *    oldest first, as a binary trace (see trace.h)
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE on error (already reported on stderr)
+ ******************************************************/
+int traceWrite(char * path)
+{
+    TraceRing * r = trace_ring;
+    TraceHeader header;
+    FILE * stream;
+
+    if (!r)
+        return FALSE;
+
+    uint64_t next = __atomic_load_n(&r->next, __ATOMIC_ACQUIRE);
+    uint64_t count = next < r->capacity ? next : r->capacity;
+    uint64_t first = next - count;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = TRACE_VERSION;
+    header.tick_us = r->tick_us;
+    header.count = count;
+    header.dropped = first;
+
+    if (!(stream = fopen(path, "wb")))
+    {
+        fprintf(stderr, "ERROR: Could not create \"%s\"\n", path);
+        return FALSE;
+    }
+
+    // the oldest event sits at 'first', the ring may wrap past its end
+    uint64_t start = first & (r->capacity - 1);
+    uint64_t tail = count < r->capacity - start ? count : r->capacity - start;
+    if (fwrite(&header, sizeof(header), 1, stream) != 1
+        || fwrite(&r->events[start], sizeof(TraceEvent), tail, stream) != tail
+        || fwrite(r->events, sizeof(TraceEvent), count - tail, stream) != count - tail)
+    {
+        fprintf(stderr, "ERROR: Could not write \"%s\"\n", path);
+        fclose(stream);
+        return FALSE;
+    }
+    if (fclose(stream) != 0)
+    {
+        fprintf(stderr, "ERROR: Could not write \"%s\"\n", path);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/*******************************************************
+ * void traceClose() - stop tracing and release the ring
+ ******************************************************/
+void traceClose(void)
+{
+    TraceRing * r = trace_ring;
+    trace_ring = NULL;
+    if (r)
+    {
+        free(r->events);
+        free(r);
+    }
+}
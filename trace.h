@@ -0,0 +1,106 @@
+/* Scheduling trace include header file for MLQD dispatcher */
+
+#ifndef MLQD_TRACE
+#define MLQD_TRACE
+
+/* Include files */
+#include <stdint.h>
+#include <time.h>
+#include "pcb.h"
+
+/* Binary trace format ****************************************
+ *
+ *   header: TraceHeader
+ *   body:   'count' TraceEvents, oldest first
+ *
+ * All fields are in host byte order. When the ring wraps, the
+ * oldest events are overwritten and counted in 'dropped'.
+ **************************************************************/
+#define TRACE_MAGIC "MLQDTRC\0"
+#define TRACE_VERSION 1
+#define TRACE_DEFAULT_EVENTS (1 << 18) // 8 MB of events
+
+/* Trace event types */
+#define TRACE_ARRIVAL 0 // job reached the Arrived Queue
+#define TRACE_ADMIT 1 // memory allocated, job joined Level-0
+#define TRACE_DISPATCH 2 // job started or resumed on CPU slot 'cpu'
+#define TRACE_SUSPEND 3 // Level-1 quantum over, job back on Level-1
+#define TRACE_DEMOTE_L1 4 // Level-0 quantum over, job moved to Level-1
+#define TRACE_DEMOTE_L2 5 // k Level-1 quanta over, job moved to Level-2
+#define TRACE_PREEMPT 6 // Level-1/2 job suspended for a Level-0 job
+#define TRACE_TERMINATE 7 // job finished
+#define TRACE_MEM_ALLOC 8 // block 'offset', 'size' allocated
+#define TRACE_MEM_FREE 9 // block 'offset', 'size' freed
+#define TRACE_TYPES 10
+
+/* Custom Data Types */
+struct trace_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t tick_us; // microseconds per unit of dispatcher time, 0 (seconds) in older traces
+    uint64_t count; // events that follow
+    uint64_t dropped; // events overwritten before the trace was written
+};
+
+struct trace_event {
+    int64_t ns; // real time since traceInit
+    int32_t time; // dispatcher time (virtual when simulated)
+    int32_t job; // Pcb id, position in the job list
+    int32_t pid; // 0 until the job first starts
+    uint8_t type;
+    uint8_t level; // queue level, where it applies
+    uint16_t cpu; // CPU slot, where it applies
+    int32_t offset; // memory events only
+    int32_t size;
+};
+
+/* Preallocated ring: writers claim a slot with one atomic add and never block */
+struct trace_ring {
+    struct trace_event * events;
+    uint64_t capacity; // a power of two
+    uint64_t next; // events claimed so far
+    struct timespec epoch;
+    uint32_t tick_us;
+};
+
+typedef struct trace_header TraceHeader;
+typedef struct trace_event TraceEvent;
+typedef struct trace_ring TraceRing;
+
+extern TraceRing * trace_ring; // NULL while tracing is off
+
+/* Function Prototypes */
+int    traceInit(int capacity, uint32_t tick_us); // allocate and prefault a ring of at least 'capacity' events
+int    traceWrite(char * path); // write the ring to 'path', oldest event first
+void   traceClose(void);
+
+/*******************************************************
+ * void traceEvent(int type, PcbPtr p, int level, int cpu,
+ *    int time, int offset, int size) - record one event
+ *
+ * A branch when tracing is off; a clock read, an atomic
+ * add and a 32 byte store when it is on.
+ ******************************************************/
+static inline void traceEvent(int type, PcbPtr p, int level, int cpu, int time, int offset, int size)
+{
+    TraceRing * r = trace_ring;
+    struct timespec now;
+
+    if (!r)
+        return;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    uint64_t i = __atomic_fetch_add(&r->next, 1, __ATOMIC_RELAXED);
+    TraceEvent * e = &r->events[i & (r->capacity - 1)];
+    e->ns = (int64_t)(now.tv_sec - r->epoch.tv_sec) * 1000000000 + (now.tv_nsec - r->epoch.tv_nsec);
+    e->time = time;
+    e->job = p ? p->id : -1;
+    e->pid = p ? p->pid : 0;
+    e->type = (uint8_t)type;
+    e->level = (uint8_t)level;
+    e->cpu = (uint16_t)cpu;
+    e->offset = offset;
+    e->size = size;
+}
+
+#endif
@@ -0,0 +1,239 @@
+/*
+    traceconv - convert a binary mlqd trace to Chrome trace JSON
+
+    usage:
+        ./traceconv [--wall] <TRACEFILE> <JSONFILE>
+        where <TRACEFILE> was written by mlqd --trace and <JSONFILE>
+        can be opened in Perfetto (ui.perfetto.dev) or chrome://tracing
+
+    The JSON has three tracks:
+        "CPU slots"  one thread per slot with a span for every quantum run
+        "jobs"       one thread per job with its Arrived Queue, Level-0/1/2
+                     queue and running spans, plus demote/preempt markers
+        "memory"     a counter of allocated megabytes
+
+    Timestamps are dispatcher time (virtual when simulated) unless --wall
+    is given, which uses the real time each event was recorded at.
+*/
+
+/* Include files */
+#include <string.h>
+#include "trace.h"
+
+#define JOB_NONE 0 // no open span (not seen yet, or finished)
+#define JOB_ARRIVED 1 // in the Arrived Queue
+#define JOB_QUEUED 2 // waiting in a Level-0/1/2 queue
+#define JOB_RUNNING 3 // running on a CPU slot
+
+struct job_state {
+    int state;
+    int level;
+    int cpu;
+    double since; // ts the open span started at
+};
+
+static struct job_state * jobs = NULL;
+static int job_capacity = 0;
+static int first_event = TRUE;
+
+static struct job_state * job_state(int job)
+{
+    if (job < 0)
+        return NULL;
+    if (job >= job_capacity)
+    {
+        int capacity = job_capacity ? job_capacity : 1024;
+        while (capacity <= job)
+            capacity *= 2;
+        if (!(jobs = (struct job_state *)realloc(jobs, capacity * sizeof(struct job_state))))
+        {
+            fprintf(stderr, "FATAL: Could not allocate job states\n");
+            exit(EXIT_FAILURE);
+        }
+        memset(jobs + job_capacity, 0, (capacity - job_capacity) * sizeof(struct job_state));
+        job_capacity = capacity;
+    }
+    return &jobs[job];
+}
+
+static void emit_sep(FILE * out)
+{
+    fprintf(out, first_event ? "\n  " : ",\n  ");
+    first_event = FALSE;
+}
+
+// a complete ("X") span on track 'pid', thread 'tid'
+static void emit_span(FILE * out, const char * name, const char * cat, int pid, int tid,
+                      double ts, double end, TraceEvent * e)
+{
+    emit_sep(out);
+    fprintf(out, "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+        "\"pid\": %d, \"tid\": %d, \"args\": {\"job\": %d, \"pid\": %d}}",
+        name, cat, ts, end - ts, pid, tid, e->job, e->pid);
+}
+
+// close the open span of 'job' at 'ts'
+static void close_span(FILE * out, struct job_state * s, TraceEvent * e, double ts)
+{
+    static const char * queue_names[LEVELS] = { "Level-0 queue", "Level-1 queue", "Level-2 queue" };
+    static const char * run_names[LEVELS] = { "run L0", "run L1", "run L2" };
+    char name[32];
+
+    if (s->state != JOB_RUNNING && ts <= s->since)
+        s->state = JOB_NONE; // left the queue as soon as it joined it
+    switch (s->state)
+    {
+        case JOB_ARRIVED:
+            emit_span(out, "Arrived Queue", "wait", 2, e->job, s->since, ts, e);
+            break;
+        case JOB_QUEUED:
+            emit_span(out, queue_names[s->level % LEVELS], "wait", 2, e->job, s->since, ts, e);
+            break;
+        case JOB_RUNNING:
+            emit_span(out, run_names[s->level % LEVELS], "run", 2, e->job, s->since, ts, e);
+            sprintf(name, "job %d L%d", e->job, s->level);
+            emit_span(out, name, "run", 1, s->cpu, s->since, ts, e);
+            break;
+    }
+    s->state = JOB_NONE;
+}
+
+static void open_span(struct job_state * s, int state, int level, int cpu, double ts)
+{
+    s->state = state;
+    s->level = level;
+    s->cpu = cpu;
+    s->since = ts;
+}
+
+static void emit_instant(FILE * out, const char * name, TraceEvent * e, double ts)
+{
+    emit_sep(out);
+    fprintf(out, "{\"name\": \"%s\", \"ph\": \"i\", \"s\": \"t\", \"ts\": %.3f, \"pid\": 2, \"tid\": %d}",
+        name, ts, e->job);
+}
+
+int main(int argc, char *argv[])
+{
+    int wall = FALSE;
+    int arg = 1;
+    TraceHeader header;
+    FILE * in, * out;
+    long allocated = 0; // megabytes
+    int max_cpu = -1;
+
+    if (argc == 4 && strcmp(argv[1], "--wall") == 0)
+    {
+        wall = TRUE;
+        arg = 2;
+    }
+    if (argc - arg != 2)
+    {
+        fprintf(stderr, "Usage: %s [--wall] <TRACEFILE> <JSONFILE>\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    if (!(in = fopen(argv[arg], "rb")))
+    {
+        fprintf(stderr, "ERROR: Could not open \"%s\"\n", argv[arg]);
+        exit(EXIT_FAILURE);
+    }
+    if (fread(&header, sizeof(header), 1, in) != 1
+        || memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0
+        || header.version != TRACE_VERSION)
+    {
+        fprintf(stderr, "ERROR: \"%s\" is not an mlqd trace\n", argv[arg]);
+        exit(EXIT_FAILURE);
+    }
+    double tick_us = header.tick_us ? header.tick_us : 1e6;
+    if (header.dropped)
+        fprintf(stderr, "traceconv: the oldest %llu events were overwritten, "
+            "spans that started before the trace begins are left out\n",
+            (unsigned long long)header.dropped);
+
+    if (!(out = fopen(argv[arg + 1], "w")))
+    {
+        fprintf(stderr, "ERROR: Could not create \"%s\"\n", argv[arg + 1]);
+        exit(EXIT_FAILURE);
+    }
+
+    fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    for (uint64_t i = 0; i < header.count; i++)
+    {
+        TraceEvent e;
+        if (fread(&e, sizeof(e), 1, in) != 1)
+        {
+            fprintf(stderr, "ERROR: \"%s\" is truncated\n", argv[arg]);
+            exit(EXIT_FAILURE);
+        }
+
+        double ts = wall ? e.ns / 1e3 : e.time * tick_us; // microseconds
+        struct job_state * s = job_state(e.job);
+        if (!s)
+            continue;
+
+        switch (e.type)
+        {
+            case TRACE_ARRIVAL:
+                open_span(s, JOB_ARRIVED, 0, 0, ts);
+                break;
+            case TRACE_ADMIT:
+                close_span(out, s, &e, ts);
+                open_span(s, JOB_QUEUED, 0, 0, ts);
+                break;
+            case TRACE_DISPATCH:
+                close_span(out, s, &e, ts);
+                open_span(s, JOB_RUNNING, e.level, e.cpu, ts);
+                if (e.cpu > max_cpu)
+                    max_cpu = e.cpu;
+                break;
+            case TRACE_SUSPEND:
+            case TRACE_DEMOTE_L1:
+            case TRACE_DEMOTE_L2:
+            case TRACE_PREEMPT:
+                close_span(out, s, &e, ts);
+                open_span(s, JOB_QUEUED, e.level, 0, ts);
+                if (e.type == TRACE_DEMOTE_L1)
+                    emit_instant(out, "demote L0->L1", &e, ts);
+                else if (e.type == TRACE_DEMOTE_L2)
+                    emit_instant(out, "demote L1->L2", &e, ts);
+                else if (e.type == TRACE_PREEMPT)
+                    emit_instant(out, "preempt", &e, ts);
+                break;
+            case TRACE_TERMINATE:
+                close_span(out, s, &e, ts);
+                break;
+            case TRACE_MEM_ALLOC:
+            case TRACE_MEM_FREE:
+                allocated += e.type == TRACE_MEM_ALLOC ? e.size : -e.size;
+                emit_sep(out);
+                fprintf(out, "{\"name\": \"memory\", \"ph\": \"C\", \"ts\": %.3f, \"pid\": 3, "
+                    "\"args\": {\"allocated MB\": %ld}}", ts, allocated);
+                break;
+        }
+    }
+
+    // name the tracks
+    emit_sep(out);
+    fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 1, \"args\": {\"name\": \"CPU slots\"}}");
+    for (int cpu = 0; cpu <= max_cpu; cpu++)
+    {
+        emit_sep(out);
+        fprintf(out, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+            "\"args\": {\"name\": \"cpu %d\"}}", cpu, cpu);
+    }
+    emit_sep(out);
+    fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 2, \"args\": {\"name\": \"jobs\"}}");
+    emit_sep(out);
+    fprintf(out, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": 3, \"args\": {\"name\": \"memory\"}}");
+    fprintf(out, "\n]}\n");
+
+    fclose(in);
+    if (fclose(out) != 0)
+    {
+        fprintf(stderr, "ERROR: Could not write \"%s\"\n", argv[arg + 1]);
+        exit(EXIT_FAILURE);
+    }
+    free(jobs);
+    exit(EXIT_SUCCESS);
+}
@@ -0,0 +1,192 @@
+/* Hierarchical timing wheel for MLQD dispatcher
+
+   Arming and cancelling a timer is O(1): it goes on the list of one
+   slot. Finding the next expiry looks at one 64-bit occupancy word per
+   level, plus the timers of one slot when the earliest is above level
+   0. Advancing the wheel across a boundary of level l re-files the one
+   slot of level l that now lies ahead ("cascading"), so every timer
+   moves down at most WHEEL_LEVELS times in its life.
+*/
+
+/* Include Files */
+#include "wheel.h"
+
+/*******************************************************
+ * static helpers
+ ******************************************************/
+
+// digit of 'time' at 'level'
+static int digit(unsigned time, int level)
+{
+    return (time >> (level * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+}
+
+static void link_timer(WheelPtr w, WheelTimerPtr t)
+{
+    unsigned due = t->expires > w->now ? (unsigned)t->expires : (unsigned)w->now;
+    unsigned diff = due ^ (unsigned)w->now;
+
+    t->level = diff < WHEEL_SLOTS ? 0 : (31 - __builtin_clz(diff)) / WHEEL_BITS;
+    t->slot = digit(due, t->level);
+    t->prev = NULL;
+    t->next = w->slots[t->level][t->slot];
+    if (t->next)
+        t->next->prev = t;
+    w->slots[t->level][t->slot] = t;
+    w->used[t->level] |= 1ULL << t->slot;
+}
+
+static void unlink_timer(WheelPtr w, WheelTimerPtr t)
+{
+    if (t->prev)
+        t->prev->next = t->next;
+    else if (!(w->slots[t->level][t->slot] = t->next))
+        w->used[t->level] &= ~(1ULL << t->slot);
+    if (t->next)
+        t->next->prev = t->prev;
+    t->level = -1;
+}
+
+// make 'time' the wheel's time, no timer may be due before it
+static void move_to(WheelPtr w, int time)
+{
+    unsigned from = (unsigned)w->now;
+
+    w->now = time;
+    for (int level = WHEEL_LEVELS - 1; level > 0; level--)
+    {
+        if ((from >> (level * WHEEL_BITS)) == ((unsigned)time >> (level * WHEEL_BITS)))
+            continue;
+        // the slot of level 'level' that 'time' has entered now lies within reach below
+        int slot = digit(time, level);
+        WheelTimerPtr t = w->slots[level][slot];
+        w->slots[level][slot] = NULL;
+        w->used[level] &= ~(1ULL << slot);
+        while (t)
+        {
+            WheelTimerPtr next = t->next;
+            link_timer(w, t);
+            t = next;
+        }
+    }
+}
+
+/*******************************************************
+ * void wheelInit(WheelPtr w, int now) - an empty wheel
+ *    whose time is 'now'
+ ******************************************************/
+void wheelInit(WheelPtr w, int now)
+{
+    for (int level = 0; level < WHEEL_LEVELS; level++)
+    {
+        w->used[level] = 0;
+        for (int slot = 0; slot < WHEEL_SLOTS; slot++)
+            w->slots[level][slot] = NULL;
+    }
+    w->now = now;
+    w->count = 0;
+}
+
+/*******************************************************
+ * void wheelTimerInit(WheelTimerPtr t, void * data) -
+ *    a disarmed timer; 'data' is left for the caller
+ ******************************************************/
+void wheelTimerInit(WheelTimerPtr t, void * data)
+{
+    t->next = t->prev = NULL;
+    t->expires = 0;
+    t->level = -1;
+    t->slot = 0;
+    t->data = data;
+}
+
+/*******************************************************
+ * void wheelArm(WheelPtr w, WheelTimerPtr t, int expires)
+ *    - make 't' fire at 'expires', or as soon as the wheel
+ *    is next expired if that has passed already
+ ******************************************************/
+void wheelArm(WheelPtr w, WheelTimerPtr t, int expires)
+{
+    if (t->level >= 0)
+        unlink_timer(w, t);
+    else
+        w->count++;
+    t->expires = expires;
+    link_timer(w, t);
+}
+
+/*******************************************************
+ * void wheelCancel(WheelPtr w, WheelTimerPtr t) - disarm
+ *    't'; nothing happens if it is not armed
+ ******************************************************/
+void wheelCancel(WheelPtr w, WheelTimerPtr t)
+{
+    if (t->level < 0)
+        return;
+    unlink_timer(w, t);
+    w->count--;
+}
+
+/*******************************************************
+ * int wheelNext(WheelPtr w) - earliest time a timer is
+ *    armed for (the wheel's time if one is due)
+ *
+ * returns:
+ *    that time, INT_MAX if no timer is armed
+ ******************************************************/
+int wheelNext(WheelPtr w)
+{
+    for (int level = 0; level < WHEEL_LEVELS && w->count; level++)
+    {
+        // level 0 holds timers from 'now' on, higher levels from the next slot on
+        int from = digit(w->now, level) + (level > 0);
+        uint64_t ahead = from < WHEEL_SLOTS ? w->used[level] & (~0ULL << from) : 0;
+        if (!ahead)
+            continue;
+
+        int slot = __builtin_ctzll(ahead);
+        if (level == 0)
+            return (int)(((unsigned)w->now & ~(unsigned)(WHEEL_SLOTS - 1)) | slot);
+        int earliest = INT_MAX;
+        for (WheelTimerPtr t = w->slots[level][slot]; t; t = t->next)
+            if (t->expires < earliest)
+                earliest = t->expires;
+        return earliest;
+    }
+    return INT_MAX;
+}
+
+/*******************************************************
+ * WheelTimerPtr wheelExpire(WheelPtr w, int now) -
+ *    advance the wheel to 'now' and disarm every timer
+ *    that is due by then
+ *
+ * returns:
+ *    the timers due, linked through 'next' in expiry
+ *    order, NULL if there are none
+ ******************************************************/
+WheelTimerPtr wheelExpire(WheelPtr w, int now)
+{
+    WheelTimerPtr due = NULL, * last = &due;
+    int next;
+
+    while ((next = wheelNext(w)) <= now)
+    {
+        move_to(w, next);
+        int slot = digit(next, 0);
+        WheelTimerPtr t = w->slots[0][slot];
+        w->slots[0][slot] = NULL;
+        w->used[0] &= ~(1ULL << slot);
+        for (; t; t = t->next)
+        {
+            t->level = -1;
+            w->count--;
+            *last = t;
+            last = &t->next;
+        }
+        *last = NULL;
+    }
+    if (now > w->now)
+        move_to(w, now);
+    return due;
+}
@@ -0,0 +1,47 @@
+/* Timing wheel include header file for MLQD dispatcher */
+
+#ifndef MLQD_WHEEL
+#define MLQD_WHEEL
+
+/* Include files */
+#include <stdint.h>
+#include <limits.h>
+#include <stddef.h>
+
+#define WHEEL_BITS 6 // slots per level: 64, one bit each in 'used'
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 6 // 36 bits of time, more than an int holds
+
+/* Custom Data Types */
+struct wheel_timer {
+    struct wheel_timer * next;
+    struct wheel_timer * prev;
+    int expires; // dispatcher time it fires at
+    int level; // -1 while not armed
+    int slot;
+    void * data; // owner, for the caller
+};
+
+/* Level l holds the timers whose expiry first differs from 'now' in bits
+   6l..6l+5, in the slot given by those bits; level 0 is exact */
+struct wheel {
+    int now;
+    int count; // armed timers
+    uint64_t used[WHEEL_LEVELS]; // slots holding at least one timer
+    struct wheel_timer * slots[WHEEL_LEVELS][WHEEL_SLOTS];
+};
+
+typedef struct wheel_timer WheelTimer;
+typedef WheelTimer * WheelTimerPtr;
+typedef struct wheel Wheel;
+typedef Wheel * WheelPtr;
+
+/* Function Prototypes */
+void   wheelInit(WheelPtr w, int now); // empty wheel at time 'now'
+void   wheelTimerInit(WheelTimerPtr t, void * data); // disarmed timer owned by 'data'
+void   wheelArm(WheelPtr w, WheelTimerPtr t, int expires); // (re)arm 't', at 'now' if 'expires' has passed
+void   wheelCancel(WheelPtr w, WheelTimerPtr t); // disarm 't', if armed
+int    wheelNext(WheelPtr w); // earliest expiry, INT_MAX if no timer is armed
+WheelTimerPtr wheelExpire(WheelPtr w, int now); // advance to 'now', returning the timers due as a list through 'next'
+
+#endif
@@ -0,0 +1,153 @@
+/* Synthetic workload generator for MLQD dispatcher
+
+   Job lists are generated from a seeded xorshift generator, so the
+   same Workload always gives the same jobs on every platform.
+*/
+
+/* Include Files */
+#include <string.h>
+#include <math.h>
+#include "workload.h"
+
+#define PARETO_ALPHA 1.5
+#define SERVICE_MAX 1000000 // cap on one job's service time, seconds
+#define BURST_JOBS 50.0 // mean jobs per burst
+
+static const char * arrival_names[] = { "poisson", "bursty", "diurnal", NULL };
+static const char * service_names[] = { "exp", "pareto", NULL };
+static const char * mem_names[] = { "small", "mixed", "large", NULL };
+
+/*******************************************************
+ * static helpers - random numbers
+ ******************************************************/
+
+// uniform in (0, 1)
+static double uniform(uint64_t * state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return ((x * 0x2545F4914F6CDD1DULL >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double exponential(uint64_t * state, double mean)
+{
+    return -mean * log(uniform(state));
+}
+
+// log-uniform integer in [lo, hi]
+static int log_uniform(uint64_t * state, int lo, int hi)
+{
+    int v = (int)exp(log(lo) + uniform(state) * (log(hi + 1.0) - log(lo)));
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+/*******************************************************
+ * void initWorkload(WorkloadPtr w) - set the defaults:
+ *    1000 Poisson arrivals at 0.5 jobs/s, exponential
+ *    service with a 5 s mean and the mixed memory sizes
+ ******************************************************/
+void initWorkload(WorkloadPtr w)
+{
+    w->jobs = 1000;
+    w->arrival = ARRIVAL_POISSON;
+    w->rate = 0.5;
+    w->burst = 10.0;
+    w->period = 3600.0;
+    w->service = SERVICE_EXP;
+    w->mean_service = 5.0;
+    w->mem = MEM_MIXED;
+    w->seed = 1;
+}
+
+/*******************************************************
+ * int parseWorkloadName(int * field, const char * kind,
+ *    const char * name) - look up 'name' among the
+ *    "arrival", "service" or "mem" names of 'kind'
+ *
+ * returns:
+ *    TRUE and sets *field if 'name' is known
+ *    FALSE otherwise
+ ******************************************************/
+int parseWorkloadName(int * field, const char * kind, const char * name)
+{
+    const char ** names = strcmp(kind, "arrival") == 0 ? arrival_names
+                        : strcmp(kind, "service") == 0 ? service_names
+                        : strcmp(kind, "mem") == 0 ? mem_names : NULL;
+    for (int i = 0; names && names[i]; i++)
+    {
+        if (strcmp(names[i], name) == 0)
+        {
+            *field = i;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+/*******************************************************
+ * int genWorkload(WorkloadPtr w, JobRecord * records)
+ *    - generate w->jobs jobs into 'records', in arrival
+ *      order
+ *
+ * returns:
+ *    TRUE on success
+ *    FALSE if the workload is invalid (reported on stderr)
+ ******************************************************/
+int genWorkload(WorkloadPtr w, JobRecord * records)
+{
+    uint64_t state = w->seed ? w->seed : 1;
+    double t = 0.0;
+    double burst_left = 0.0; // ARRIVAL_BURSTY jobs left in the current burst
+
+    if (w->jobs < 0 || w->rate <= 0.0 || w->mean_service < 1.0 || w->burst < 1.0 || w->period <= 0.0)
+    {
+        fprintf(stderr, "ERROR: Invalid workload: rate and period must be positive, "
+            "mean service and burst at least 1\n");
+        return FALSE;
+    }
+
+    for (int i = 0; i < w->jobs; i++)
+    {
+        // A. arrival time
+        switch (w->arrival)
+        {
+            case ARRIVAL_POISSON:
+                t += exponential(&state, 1.0 / w->rate);
+                break;
+            case ARRIVAL_BURSTY:
+                // a burst runs at burst x rate; the gap before the next
+                // one keeps the mean at 'rate'
+                if (burst_left <= 0.0)
+                {
+                    burst_left = exponential(&state, BURST_JOBS);
+                    t += exponential(&state, BURST_JOBS / w->rate * (1.0 - 1.0 / w->burst));
+                }
+                burst_left -= 1.0;
+                t += exponential(&state, 1.0 / (w->rate * w->burst));
+                break;
+            case ARRIVAL_DIURNAL:
+                // thinning: draw at the peak rate, keep with probability rate(t) / peak
+                do
+                    t += exponential(&state, 1.0 / (1.8 * w->rate));
+                while (uniform(&state) * 1.8 > 1.0 + 0.8 * sin(2.0 * M_PI * t / w->period));
+                break;
+        }
+        records[i].arrival_time = t < 2e9 ? (int32_t)t : 2000000000;
+
+        // B. service time, at least one second
+        double service = w->service == SERVICE_PARETO
+            ? w->mean_service * (PARETO_ALPHA - 1.0) / PARETO_ALPHA * pow(uniform(&state), -1.0 / PARETO_ALPHA)
+            : exponential(&state, w->mean_service);
+        service = ceil(service);
+        records[i].service_time = service > SERVICE_MAX ? SERVICE_MAX : (int32_t)service;
+
+        // C. memory size
+        records[i].mem_size = w->mem == MEM_SMALL ? log_uniform(&state, 1, 64)
+                            : w->mem == MEM_LARGE ? log_uniform(&state, 256, MEM_LIMIT)
+                            : log_uniform(&state, 1, 1024);
+    }
+    return TRUE;
+}
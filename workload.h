@@ -0,0 +1,45 @@
+/* Synthetic workload include header file for MLQD dispatcher */
+
+#ifndef MLQD_WORKLOAD
+#define MLQD_WORKLOAD
+
+/* Include files */
+#include <stdint.h>
+#include "jobfile.h"
+
+/* Arrival processes */
+#define ARRIVAL_POISSON 0 // exponential inter-arrival times at 'rate'
+#define ARRIVAL_BURSTY 1 // on/off: bursts at 'burst' x 'rate', idle between, same mean rate
+#define ARRIVAL_DIURNAL 2 // rate swings +-80% around 'rate' over 'period' seconds
+
+/* Service time distributions */
+#define SERVICE_EXP 0 // exponential with mean 'service'
+#define SERVICE_PARETO 1 // Pareto (alpha 1.5) with mean 'service', heavy tailed
+
+/* Memory size mixes, megabytes */
+#define MEM_SMALL 0 // 1 - 64, log-uniform
+#define MEM_MIXED 1 // 1 - 1024, log-uniform
+#define MEM_LARGE 2 // 256 - MEM_LIMIT, log-uniform
+
+/* Custom Data Types */
+struct workload {
+    int jobs;
+    int arrival; // ARRIVAL_*
+    double rate; // mean arrivals per second
+    double burst; // ARRIVAL_BURSTY rate multiplier while a burst is on
+    double period; // ARRIVAL_DIURNAL cycle length in seconds
+    int service; // SERVICE_*
+    double mean_service; // seconds
+    int mem; // MEM_*
+    uint64_t seed;
+};
+
+typedef struct workload Workload;
+typedef Workload * WorkloadPtr;
+
+/* Function Prototypes */
+void   initWorkload(WorkloadPtr w); // defaults: 1000 Poisson jobs at 0.5/s, exp(5 s), mixed memory
+int    parseWorkloadName(int * field, const char * kind, const char * name); // "poisson" -> ARRIVAL_POISSON etc.
+int    genWorkload(WorkloadPtr w, JobRecord * records); // fill w->jobs records in arrival order
+
+#endif